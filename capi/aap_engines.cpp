@@ -0,0 +1,96 @@
+#include "aap_engines.h"
+
+#include "engine.h"
+
+aap_engine* aap_engine_create(aap_engine_type type) {
+  switch (type) {
+    case AAP_ENGINE_REVERB2:
+      return createReverb2Engine();
+    case AAP_ENGINE_DELAY:
+      return createDelayEngine();
+  }
+  return nullptr;
+}
+
+void aap_engine_destroy(aap_engine* engine) { delete engine; }
+
+aap_result aap_engine_prepare(aap_engine* engine, double sample_rate,
+                              int max_block_size) {
+  if (engine == nullptr || sample_rate <= 0 || max_block_size <= 0)
+    return AAP_ERROR_INVALID_ARGUMENT;
+
+  auto& processor = engine->getProcessor();
+  if (engine->maxBlockSize > 0) processor.releaseResources();
+  processor.setRateAndBufferSizeDetails(sample_rate, max_block_size);
+  processor.prepareToPlay(sample_rate, max_block_size);
+  engine->maxBlockSize = max_block_size;
+  return AAP_OK;
+}
+
+// The base class list, as the processors' own getParameters() copies theirs
+static AudioProcessorParameter* getParameter(const aap_engine* engine,
+                                             int param) {
+  const auto& parameters = engine->getProcessor().getParameters();
+  return param >= 0 && param < parameters.size() ? parameters[param] : nullptr;
+}
+
+aap_result aap_engine_set_param(aap_engine* engine, int param, float value) {
+  if (engine == nullptr) return AAP_ERROR_INVALID_ARGUMENT;
+
+  auto* parameter = getParameter(engine, param);
+  if (parameter == nullptr) return AAP_ERROR_INVALID_ARGUMENT;
+
+  parameter->setValue(jlimit(0.0f, 1.0f, value));
+  return AAP_OK;
+}
+
+float aap_engine_get_param(const aap_engine* engine, int param) {
+  if (engine == nullptr) return 0.0f;
+
+  const auto* parameter = getParameter(engine, param);
+  return parameter != nullptr ? parameter->getValue() : 0.0f;
+}
+
+int aap_engine_get_num_params(const aap_engine* engine) {
+  if (engine == nullptr) return 0;
+  return engine->getProcessor().getParameters().size();
+}
+
+aap_result aap_engine_process(aap_engine* engine, const float* const* in,
+                              float* const* out, int num_samples) {
+  if (engine == nullptr || in == nullptr || out == nullptr || num_samples < 0)
+    return AAP_ERROR_INVALID_ARGUMENT;
+  if (engine->maxBlockSize == 0) return AAP_ERROR_NOT_PREPARED;
+
+  engine->process(in[0], in[1], out[0], out[1], num_samples);
+  return AAP_OK;
+}
+
+int aap_engine_get_latency(const aap_engine* engine) {
+  if (engine == nullptr) return 0;
+  return engine->getProcessor().getLatencySamples();
+}
+
+size_t aap_engine_get_state(aap_engine* engine, void* data, size_t size) {
+  if (engine == nullptr) return 0;
+
+  MemoryBlock state;
+  engine->getProcessor().getStateInformation(state);
+  if (data != nullptr && state.getSize() <= size)
+    std::memcpy(data, state.getData(), state.getSize());
+  return state.getSize();
+}
+
+aap_result aap_engine_set_state(aap_engine* engine, const void* data,
+                                size_t size) {
+  if (engine == nullptr || data == nullptr ||
+      size > static_cast<size_t>(std::numeric_limits<int>::max()))
+    return AAP_ERROR_INVALID_ARGUMENT;
+
+  engine->getProcessor().setStateInformation(data, static_cast<int>(size));
+  return AAP_OK;
+}
+
+const char* aap_engine_get_kernel_variant(const aap_engine* engine) {
+  return engine != nullptr ? engine->getKernelVariant() : "";
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+/* C API for the reverb2 and delay engines, for callers that are not plugin
+ * hosts. Audio is stereo and planar, in caller-owned buffers; processing
+ * works on them directly, without copies or allocations. */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+#ifdef AAP_ENGINES_BUILD
+#define AAP_API __declspec(dllexport)
+#else
+#define AAP_API __declspec(dllimport)
+#endif
+#else
+#define AAP_API __attribute__((visibility("default")))
+#endif
+
+typedef struct aap_engine aap_engine;
+
+typedef enum aap_engine_type {
+  AAP_ENGINE_REVERB2 = 0,
+  AAP_ENGINE_DELAY = 1
+} aap_engine_type;
+
+/* Parameters, in the order of the plugins' parameter lists. Values are
+ * normalised to 0..1 like the plugins' parameters. */
+typedef enum aap_reverb2_param {
+  AAP_REVERB2_MIX = 0,
+  AAP_REVERB2_PREDELAY,
+  AAP_REVERB2_SIZE,
+  AAP_REVERB2_DECAY,
+  AAP_REVERB2_SPEED,
+  AAP_REVERB2_DEPTH,
+  AAP_REVERB2_DAMPING,
+  AAP_REVERB2_QUALITY,
+  AAP_REVERB2_ADAPTIVE,
+  AAP_REVERB2_PIPELINE,
+  AAP_REVERB2_BYPASS,
+  AAP_REVERB2_NUM_PARAMS
+} aap_reverb2_param;
+
+/* reverb2 has AAP_REVERB2_AUX_PARAMS parameters, a send and a predelay, per
+ * aux input of its shared tank mode after these. Aux inputs only exist in
+ * plugin hosts, so they have no effect through this API. The early
+ * reflections level follows them. */
+enum {
+  AAP_REVERB2_MAX_AUX = 16,
+  AAP_REVERB2_AUX_PARAMS = 2,
+  AAP_REVERB2_EARLY =
+      AAP_REVERB2_NUM_PARAMS + AAP_REVERB2_MAX_AUX * AAP_REVERB2_AUX_PARAMS
+};
+
+typedef enum aap_delay_param {
+  AAP_DELAY_MIX = 0,
+  AAP_DELAY_TIME,
+  AAP_DELAY_FEEDBACK,
+  AAP_DELAY_QUALITY,
+  AAP_DELAY_ADAPTIVE,
+  AAP_DELAY_LONG_DELAY,
+  AAP_DELAY_BYPASS,
+  AAP_DELAY_LONG_TIME,
+  AAP_DELAY_NUM_PARAMS
+} aap_delay_param;
+
+typedef enum aap_result {
+  AAP_OK = 0,
+  AAP_ERROR_INVALID_ARGUMENT = -1,
+  AAP_ERROR_NOT_PREPARED = -2
+} aap_result;
+
+/* Returns NULL for an unknown type. */
+AAP_API aap_engine* aap_engine_create(aap_engine_type type);
+AAP_API void aap_engine_destroy(aap_engine* engine);
+
+/* Allocates everything processing needs. Not real-time safe. Call again to
+ * change the sample rate or block size, or after changing a parameter that
+ * is only read here (reverb2 pipeline, delay long delay). */
+AAP_API aap_result aap_engine_prepare(aap_engine* engine, double sample_rate,
+                                      int max_block_size);
+
+/* Real-time safe. */
+AAP_API aap_result aap_engine_set_param(aap_engine* engine, int param,
+                                        float value);
+AAP_API float aap_engine_get_param(const aap_engine* engine, int param);
+AAP_API int aap_engine_get_num_params(const aap_engine* engine);
+
+/* Processes num_samples samples of in[0..1] into out[0..1]. out may be the
+ * same buffers as in. Blocks longer than the prepared block size are
+ * processed in parts. Real-time safe. */
+AAP_API aap_result aap_engine_process(aap_engine* engine,
+                                      const float* const* in,
+                                      float* const* out, int num_samples);
+
+/* Latency in samples the engine adds to its output */
+AAP_API int aap_engine_get_latency(const aap_engine* engine);
+
+/* Writes the state into data if it fits in size bytes; returns the number of
+ * bytes the state takes either way. State calls are not real-time safe. */
+AAP_API size_t aap_engine_get_state(aap_engine* engine, void* data,
+                                    size_t size);
+AAP_API aap_result aap_engine_set_state(aap_engine* engine, const void* data,
+                                        size_t size);
+
+/* Name of the DSP kernel variant the engine runs, such as "avx2" */
+AAP_API const char* aap_engine_get_kernel_variant(const aap_engine* engine);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,35 @@
+#include "delay_processor.h"
+#include "engine.h"
+
+// aap_delay_param has to follow the processor's parameter order
+static_assert(int{AAP_DELAY_MIX} == DelayParameters::Mix);
+static_assert(int{AAP_DELAY_TIME} == DelayParameters::Time);
+static_assert(int{AAP_DELAY_FEEDBACK} == DelayParameters::Feedback);
+static_assert(int{AAP_DELAY_QUALITY} == DelayParameters::Quality);
+static_assert(int{AAP_DELAY_ADAPTIVE} == DelayParameters::Adaptive);
+static_assert(int{AAP_DELAY_LONG_DELAY} == DelayParameters::LongDelay);
+static_assert(int{AAP_DELAY_BYPASS} == DelayParameters::Bypass);
+static_assert(int{AAP_DELAY_LONG_TIME} == DelayParameters::LongTime);
+static_assert(int{AAP_DELAY_NUM_PARAMS} == DelayParameters::End);
+
+namespace {
+
+struct DelayEngine : aap_engine {
+  AudioProcessor& getProcessor() override { return processor; }
+  const AudioProcessor& getProcessor() const override { return processor; }
+
+  void process(const float* inL, const float* inR, float* outL, float* outR,
+               int numSamples) override {
+    processor.process(inL, inR, outL, outR, numSamples);
+  }
+
+  const char* getKernelVariant() const override {
+    return processor.getKernelVariant();
+  }
+
+  DelayAudioProcessor processor;
+};
+
+}  // namespace
+
+aap_engine* createDelayEngine() { return new DelayEngine(); }
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include "aap_engines.h"
+
+using namespace juce;
+
+// What the C API needs from a processor, one implementation per engine
+struct aap_engine {
+  virtual ~aap_engine() = default;
+
+  virtual AudioProcessor& getProcessor() = 0;
+  virtual const AudioProcessor& getProcessor() const = 0;
+  virtual void process(const float* inL, const float* inR, float* outL,
+                       float* outR, int numSamples) = 0;
+  virtual const char* getKernelVariant() const = 0;
+
+  int maxBlockSize{};
+};
+
+aap_engine* createReverb2Engine();
+aap_engine* createDelayEngine();
@@ -0,0 +1,41 @@
+#include "reverb2_processor.h"
+#include "engine.h"
+
+// aap_reverb2_param has to follow the processor's parameter order
+static_assert(int{AAP_REVERB2_MIX} == ReverbParameters::Mix);
+static_assert(int{AAP_REVERB2_PREDELAY} == ReverbParameters::PreDelay);
+static_assert(int{AAP_REVERB2_SIZE} == ReverbParameters::Size);
+static_assert(int{AAP_REVERB2_DECAY} == ReverbParameters::Decay);
+static_assert(int{AAP_REVERB2_SPEED} == ReverbParameters::Speed);
+static_assert(int{AAP_REVERB2_DEPTH} == ReverbParameters::Depth);
+static_assert(int{AAP_REVERB2_DAMPING} == ReverbParameters::Damping);
+static_assert(int{AAP_REVERB2_QUALITY} == ReverbParameters::Quality);
+static_assert(int{AAP_REVERB2_ADAPTIVE} == ReverbParameters::Adaptive);
+static_assert(int{AAP_REVERB2_PIPELINE} == ReverbParameters::Pipeline);
+static_assert(int{AAP_REVERB2_BYPASS} == ReverbParameters::Bypass);
+static_assert(int{AAP_REVERB2_NUM_PARAMS} == ReverbParameters::End);
+static_assert(int{AAP_REVERB2_MAX_AUX} == MaxAuxInputs);
+static_assert(int{AAP_REVERB2_AUX_PARAMS} == NumAuxParameters);
+static_assert(int{AAP_REVERB2_EARLY} == EarlyLevel);
+
+namespace {
+
+struct Reverb2Engine : aap_engine {
+  AudioProcessor& getProcessor() override { return processor; }
+  const AudioProcessor& getProcessor() const override { return processor; }
+
+  void process(const float* inL, const float* inR, float* outL, float* outR,
+               int numSamples) override {
+    processor.process(inL, inR, outL, outR, numSamples);
+  }
+
+  const char* getKernelVariant() const override {
+    return processor.getKernelVariant();
+  }
+
+  Reverb2AudioProcessor processor;
+};
+
+}  // namespace
+
+aap_engine* createReverb2Engine() { return new Reverb2Engine(); }
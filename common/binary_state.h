@@ -0,0 +1,90 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+using namespace juce;
+
+// Name used for the legacy XML state, display name and default value of a
+// parameter. numSteps is 0 for continuous parameters.
+struct ParameterSpec {
+  const char* key;
+  const char* name;
+  float defaultValue;
+  int numSteps = 0;
+};
+
+// Compact plugin state: a four-character tag, a format version, a parameter
+// count and one little-endian float per parameter, in parameter order.
+// Reading never allocates. Parameters missing from an older state are reset
+// to their defaults and extra ones written by a newer version are skipped.
+// States of a newer format version are rejected, as their parameters may not
+// line up.
+namespace BinaryState {
+
+constexpr std::uint16_t Version = 1;
+constexpr size_t HeaderSize = 8;
+
+inline void write(MemoryBlock& dest, const char (&tag)[5],
+                  const std::vector<AudioProcessorParameter*>& params) {
+  const auto count = static_cast<std::uint16_t>(params.size());
+  dest.setSize(HeaderSize + sizeof(float) * count);
+  auto* out = static_cast<char*>(dest.getData());
+
+  const auto version = ByteOrder::swapIfBigEndian(Version);
+  const auto swappedCount = ByteOrder::swapIfBigEndian(count);
+  std::memcpy(out, tag, 4);
+  std::memcpy(out + 4, &version, 2);
+  std::memcpy(out + 6, &swappedCount, 2);
+  out += HeaderSize;
+
+  for (auto* param : params) {
+    const auto value = param->getValue();
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    bits = ByteOrder::swapIfBigEndian(bits);
+    std::memcpy(out, &bits, sizeof(bits));
+    out += sizeof(bits);
+  }
+}
+
+// What read() made of the data
+enum class ReadResult {
+  // Not a binary state with this tag; the caller may try the legacy format
+  NotBinary,
+  // A binary state of a newer format version, left alone
+  TooNew,
+  Loaded
+};
+
+inline ReadResult read(const void* data, int sizeInBytes,
+                       const char (&tag)[5],
+                       const std::vector<AudioProcessorParameter*>& params) {
+  const auto* in = static_cast<const char*>(data);
+  if (in == nullptr || sizeInBytes < static_cast<int>(HeaderSize) ||
+      std::memcmp(in, tag, 4) != 0)
+    return ReadResult::NotBinary;
+
+  if (static_cast<std::uint16_t>(ByteOrder::littleEndianShort(in + 4)) >
+      Version)
+    return ReadResult::TooNew;
+
+  const auto stored = static_cast<size_t>(ByteOrder::littleEndianShort(in + 6));
+  const auto available =
+      (static_cast<size_t>(sizeInBytes) - HeaderSize) / sizeof(float);
+  const auto count = std::min({stored, available, params.size()});
+  in += HeaderSize;
+
+  for (size_t i = 0; i < count; ++i) {
+    const auto bits = ByteOrder::littleEndianInt(in + i * sizeof(float));
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    params[i]->setValue(value);
+  }
+  for (auto i = count; i < params.size(); ++i) {
+    params[i]->setValue(params[i]->getDefaultValue());
+  }
+
+  return ReadResult::Loaded;
+}
+
+}  // namespace BinaryState
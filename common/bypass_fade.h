@@ -0,0 +1,65 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include <utility>
+
+using namespace juce;
+
+// Host bypass with a short crossfade. While the fade runs the processor
+// runs too and its output is mixed with a copy of the dry input; once fully
+// bypassed the processor is not run at all. Its memory is cleared once on
+// the way in, so that it comes back from silence.
+class BypassFade {
+ public:
+  enum class Stage { Active, Fading, Bypassed };
+
+  void prepare(double sampleRate, int maxBlockSize, bool bypassed) {
+    step_ = static_cast<float>(1.0 / (FadeSeconds * sampleRate));
+    gain_ = bypassed ? 0.0f : 1.0f;
+    cleared_ = false;
+    for (auto& dry : dry_) {
+      dry.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+    }
+  }
+
+  Stage getStage(bool bypass) const {
+    if (gain_ != (bypass ? 0.0f : 1.0f)) return Stage::Fading;
+    return bypass ? Stage::Bypassed : Stage::Active;
+  }
+
+  // True on the first fully bypassed block, when the processor should clear
+  // its memory
+  bool enterBypassed() { return !std::exchange(cleared_, true); }
+
+  // True on the first block the processor runs after being cleared, when it
+  // should start at the current parameters instead of gliding to them
+  bool leaveBypassed() { return std::exchange(cleared_, false); }
+
+  // Where a fading block keeps its dry input, as the processor may write
+  // over it
+  float* getDry(std::size_t channel) { return dry_[channel].data(); }
+
+  // Mixes the processed block in out with the dry copy, stepping the fade
+  // towards bypass or back
+  void fade(float* outL, float* outR, int numSamples, bool bypass) {
+    const auto target = bypass ? 0.0f : 1.0f;
+    const auto* dryL = dry_[0].data();
+    const auto* dryR = dry_[1].data();
+    for (auto i = 0; i < numSamples; ++i) {
+      gain_ = bypass ? jmax(target, gain_ - step_)
+                     : jmin(target, gain_ + step_);
+      outL[i] = dryL[i] + gain_ * (outL[i] - dryL[i]);
+      outR[i] = dryR[i] + gain_ * (outR[i] - dryR[i]);
+    }
+  }
+
+ private:
+  static constexpr double FadeSeconds = 0.02;
+
+  // Gain of the processed signal, 0 when bypassed
+  float gain_{1.0f};
+  float step_{};
+  bool cleared_{};
+  std::array<std::vector<float>, 2> dry_{};
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include "delay_memory_pool.h"
+
+using namespace juce;
+
+// Ring buffer delay line. size() is the nominal length the owner scales its
+// delay times by; the memory comes from the DelayMemoryPool in allocate() and
+// may be longer, for owners that read further back than the nominal length.
+// Block reads and writes of up to capacity() samples are contiguous.
+class Delay {
+ public:
+  Delay() = default;
+  Delay(std::uint32_t size) : size_(size) {}
+
+  inline void allocate(std::uint32_t minCapacity = 0) {
+    buffer_ = DelayMemoryPool::getInstance().acquire(jmax(size_, minCapacity));
+    capacity_ = buffer_.size();
+    index_ = 0;
+  }
+
+  inline void release() {
+    buffer_.reset();
+    capacity_ = 0;
+    index_ = 0;
+  }
+
+  inline void clear() {
+    buffer_.clear();
+    index_ = 0;
+  }
+
+  inline float read(float delay) const {
+    auto m = index_ - delay;
+    if (m < 0) m += capacity_;
+
+    return buffer_[m];
+  }
+
+  inline void write(float in) {
+    buffer_.write(index_++, in);
+    if (index_ >= capacity_) index_ = 0;
+  }
+
+  // Copies the next numSamples values read(delay) will return, assuming
+  // numSamples <= delay so none of them is written in the meantime.
+  inline void readBlock(float* out, int numSamples,
+                        std::uint32_t delay) const {
+    FloatVectorOperations::copy(out, readPointer(delay), numSamples);
+  }
+
+  // Where the values readBlock() would copy start, for reading them in
+  // place. Up to capacity() of them are contiguous.
+  inline const float* readPointer(std::uint32_t delay) const {
+    const auto readIndex =
+        index_ >= delay ? index_ - delay : index_ + capacity_ - delay;
+    return buffer_.data() + readIndex;
+  }
+
+  inline void writeBlock(const float* in, int numSamples) {
+    FloatVectorOperations::copy(buffer_.data() + index_, in, numSamples);
+    commit(numSamples);
+  }
+
+  // Writes in + gain * add for numSamples samples.
+  inline void writeBlock(const float* in, const float* add, float gain,
+                         int numSamples) {
+    auto* write = buffer_.data() + index_;
+    FloatVectorOperations::copy(write, in, numSamples);
+    FloatVectorOperations::addWithMultiply(write, add, gain, numSamples);
+    commit(numSamples);
+  }
+
+  inline std::uint32_t size() const { return size_; }
+  inline std::uint32_t capacity() const { return capacity_; }
+
+ private:
+  inline void commit(int numSamples) {
+    buffer_.commit(index_, static_cast<std::uint32_t>(numSamples));
+    index_ += static_cast<std::uint32_t>(numSamples);
+    if (index_ >= capacity_) index_ -= capacity_;
+  }
+
+  DelayMemoryPool::Block buffer_{};
+  std::uint32_t size_{};
+  std::uint32_t capacity_{};
+  std::uint32_t index_{};
+};
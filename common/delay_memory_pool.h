@@ -0,0 +1,110 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include "mirrored_buffer.h"
+
+// Process-wide free list of delay line memory. Instances take their buffers
+// in prepareToPlay and hand them back in releaseResources, so an instance
+// that is never played holds no delay memory and buffers released by one
+// instance are reused by the next one instead of going back to the heap.
+// Buffers are MirroredBuffers, so block reads and writes need no wrap
+// handling. Not for the audio thread: acquiring and releasing take a lock.
+class DelayMemoryPool {
+ public:
+  // Zeroed ring buffer borrowed from the pool, returned on destruction.
+  // size() may be larger than requested.
+  class Block {
+   public:
+    Block() = default;
+    Block(Block&& other) noexcept = default;
+    Block& operator=(Block&& other) noexcept {
+      reset();
+      buffer_ = std::move(other.buffer_);
+      return *this;
+    }
+    ~Block() { reset(); }
+
+    inline float* data() { return buffer_.data(); }
+    inline const float* data() const { return buffer_.data(); }
+    inline float& operator[](std::size_t i) { return buffer_[i]; }
+    inline const float& operator[](std::size_t i) const { return buffer_[i]; }
+    inline std::uint32_t size() const { return buffer_.size(); }
+
+    inline void write(std::uint32_t index, float value) {
+      buffer_.write(index, value);
+    }
+    inline void commit(std::uint32_t start, std::uint32_t numSamples) {
+      buffer_.commit(start, numSamples);
+    }
+    inline void clear() { buffer_.clear(); }
+
+    void reset() {
+      if (buffer_.size() > 0) getInstance().recycle(std::move(buffer_));
+      buffer_ = {};
+    }
+
+   private:
+    friend class DelayMemoryPool;
+    MirroredBuffer buffer_{};
+  };
+
+  static DelayMemoryPool& getInstance() {
+    static DelayMemoryPool pool;
+    return pool;
+  }
+
+  Block acquire(std::uint32_t numSamples) {
+    Block block;
+    if (numSamples == 0) return block;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      // Smallest free buffer that is large enough without wasting half of it
+      auto best = free_.end();
+      for (auto it = free_.begin(); it != free_.end(); ++it) {
+        if (it->size() >= numSamples && it->size() / 2 < numSamples &&
+            (best == free_.end() || it->size() < best->size()))
+          best = it;
+      }
+
+      if (best != free_.end()) {
+        block.buffer_ = std::move(*best);
+        freeSamples_ -= block.buffer_.size();
+        free_.erase(best);
+      }
+    }
+
+    if (block.buffer_.size() == 0) {
+      block.buffer_ = MirroredBuffer(numSamples);
+    } else {
+      block.buffer_.clear();
+    }
+
+    return block;
+  }
+
+  std::size_t getFreeBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return freeSamples_ * sizeof(float);
+  }
+
+ private:
+  // Memory beyond this is given back to the heap rather than kept around
+  static constexpr std::size_t MaxFreeSamples = 16 * 1024 * 1024;
+
+  DelayMemoryPool() = default;
+
+  void recycle(MirroredBuffer&& buffer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (freeSamples_ + buffer.size() > MaxFreeSamples) return;
+    freeSamples_ += buffer.size();
+    free_.push_back(std::move(buffer));
+  }
+
+  mutable std::mutex mutex_;
+  std::vector<MirroredBuffer> free_{};
+  std::size_t freeSamples_{};
+};
@@ -0,0 +1,50 @@
+#include "disk_delay.h"
+
+#if JUCE_WINDOWS
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace DiskPages {
+
+std::size_t getPageSize() {
+#if JUCE_WINDOWS
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwPageSize;
+#else
+  return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+void populate(void* start, std::size_t numBytes, bool forWrite) {
+#if defined(MADV_POPULATE_WRITE)
+  if (madvise(start, numBytes, forWrite ? MADV_POPULATE_WRITE
+                                        : MADV_POPULATE_READ) == 0)
+    return;
+#endif
+
+  // Touch one value per page. A read maps the page; the first write to it
+  // may still take a minor fault, but never waits for the disk.
+  const auto pageSize = getPageSize();
+  auto* bytes = static_cast<volatile const char*>(start);
+  for (std::size_t offset = 0; offset < numBytes; offset += pageSize) {
+    static_cast<void>(bytes[offset]);
+  }
+  ignoreUnused(forWrite);
+}
+
+void evict(void* start, std::size_t numBytes) {
+#if JUCE_WINDOWS
+  FlushViewOfFile(start, numBytes);
+  // Unlocking pages that are not locked takes them out of the working set
+  VirtualUnlock(start, numBytes);
+#else
+  msync(start, numBytes, MS_SYNC);
+  madvise(start, numBytes, MADV_DONTNEED);
+#endif
+}
+
+}  // namespace DiskPages
@@ -0,0 +1,319 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include <atomic>
+
+using namespace juce;
+
+// Page residency control for memory-mapped files, in disk_delay.cpp
+namespace DiskPages {
+std::size_t getPageSize();
+// Faults pages in ahead of use, writable if forWrite
+void populate(void* start, std::size_t numBytes, bool forWrite);
+// Writes pages back to the file and drops them from the process
+void evict(void* start, std::size_t numBytes);
+}  // namespace DiskPages
+
+// Ring buffer of interleaved N-channel frames backed by a memory-mapped
+// temporary file, for delays far too long to keep in memory. Reads and
+// writes follow FrameDelay, except that a frame is written whole.
+//
+// A pager thread keeps a window of pages around the write head and the read
+// head resident and writes back and drops everything the heads have left
+// behind, so the resident memory is bounded by the window size whatever the
+// delay length. The audio thread only publishes where the heads are. If the
+// pager falls behind, the audio thread takes the page faults itself.
+//
+// clear() does not touch the file, which could be far more than the audio
+// thread can zero: frames written before it simply read back as silence.
+template <std::size_t NumChannels>
+class DiskFrameDelay {
+ public:
+  using Frame = std::array<float, NumChannels>;
+
+  DiskFrameDelay() = default;
+  ~DiskFrameDelay() { release(); }
+
+  // Creates and maps the backing file for size frames and starts the pager,
+  // keeping windowFrames frames either side of each head resident. Returns
+  // false if the file could not be created or mapped.
+  bool allocate(std::uint32_t size, std::uint32_t windowFrames) {
+    release();
+
+    // Whole pages of whole frames
+    const auto framesPerPage = static_cast<std::uint32_t>(
+        jmax<std::size_t>(1, DiskPages::getPageSize() / sizeof(Frame)));
+    const auto numPages = (size + framesPerPage - 1) / framesPerPage;
+    const auto numBytes = static_cast<int64>(numPages) * framesPerPage *
+                          static_cast<int64>(sizeof(Frame));
+
+    file_ = std::make_unique<TemporaryFile>(".delay");
+    {
+      // A sparse file of zeros: write the last byte only
+      FileOutputStream out(file_->getFile());
+      const char zero = 0;
+      if (!out.openedOk() || !out.setPosition(numBytes - 1) ||
+          !out.write(&zero, 1)) {
+        release();
+        return false;
+      }
+    }
+
+    map_ = std::make_unique<MemoryMappedFile>(file_->getFile(),
+                                              MemoryMappedFile::readWrite);
+    if (map_->getData() == nullptr ||
+        static_cast<int64>(map_->getSize()) < numBytes) {
+      release();
+      return false;
+    }
+
+    data_ = static_cast<float*>(map_->getData());
+    size_ = size;
+    capacity_ = numPages * framesPerPage;
+    index_ = 0;
+    written_ = 0;
+    writeHead_.store(0);
+    readHead_.store(0);
+
+    pager_ = std::make_unique<Pager>(*this, framesPerPage, windowFrames);
+    pager_->startThread();
+    return true;
+  }
+
+  void release() {
+    pager_.reset();
+    data_ = nullptr;
+    map_.reset();
+    file_.reset();
+    size_ = 0;
+    capacity_ = 0;
+    index_ = 0;
+    written_ = 0;
+  }
+
+  inline void clear() { written_ = 0; }
+
+  inline Frame readFrame(std::uint32_t delay) const {
+    const auto readIndex = frameIndex(delay);
+    readHead_.store(readIndex, std::memory_order_relaxed);
+
+    Frame frame{};
+    if (delay <= written_) {
+      std::memcpy(frame.data(), data_ + readIndex * NumChannels,
+                  sizeof(Frame));
+    }
+    return frame;
+  }
+
+  inline Frame readFrameInterpolated(double delay) const {
+    const auto whole = static_cast<std::uint32_t>(delay);
+    const auto frac = static_cast<float>(delay - whole);
+    const auto newer = readFrame(whole);
+    const auto older = readFrame(whole + 1);
+
+    Frame frame;
+    for (std::size_t channel = 0; channel < NumChannels; ++channel) {
+      frame[channel] =
+          newer[channel] + frac * (older[channel] - newer[channel]);
+    }
+    return frame;
+  }
+
+  inline void writeFrame(const Frame& frame) {
+    std::memcpy(data_ + index_ * NumChannels, frame.data(), sizeof(Frame));
+    if (++index_ >= capacity_) index_ = 0;
+    written_ = jmin(written_ + 1, capacity_);
+    writeHead_.store(index_, std::memory_order_relaxed);
+  }
+
+  // Copies the next numFrames frames readFrame(delay) will return,
+  // interleaved, assuming numFrames <= delay.
+  inline void readFrames(float* out, int numFrames,
+                         std::uint32_t delay) const {
+    const auto readIndex = frameIndex(delay);
+    readHead_.store(readIndex, std::memory_order_relaxed);
+
+    // Frames from before the last clear() lead the run
+    const auto stale = static_cast<int>(
+        jmin<std::uint32_t>(static_cast<std::uint32_t>(numFrames),
+                            delay > written_ ? delay - written_ : 0));
+    FloatVectorOperations::clear(out,
+                                 stale * static_cast<int>(NumChannels));
+    if (stale == numFrames) return;
+
+    const auto start = (readIndex + stale) % capacity_;
+    const auto count = static_cast<std::uint32_t>(numFrames - stale);
+    out += stale * NumChannels;
+
+    const auto first = jmin(count, capacity_ - start);
+    FloatVectorOperations::copy(out, data_ + start * NumChannels,
+                                static_cast<int>(first * NumChannels));
+    FloatVectorOperations::copy(
+        out + first * NumChannels, data_,
+        static_cast<int>((count - first) * NumChannels));
+  }
+
+  inline void writeFrames(const float* in, int numFrames) {
+    const auto first =
+        jmin(static_cast<std::uint32_t>(numFrames), capacity_ - index_);
+    FloatVectorOperations::copy(data_ + index_ * NumChannels, in,
+                                static_cast<int>(first * NumChannels));
+    FloatVectorOperations::copy(
+        data_, in + first * NumChannels,
+        static_cast<int>((numFrames - first) * NumChannels));
+
+    index_ += static_cast<std::uint32_t>(numFrames);
+    if (index_ >= capacity_) index_ -= capacity_;
+    written_ =
+        jmin(written_ + static_cast<std::uint32_t>(numFrames), capacity_);
+    writeHead_.store(index_, std::memory_order_relaxed);
+  }
+
+  inline std::uint32_t size() const { return size_; }
+  inline std::uint32_t capacity() const { return capacity_; }
+
+ private:
+  // Pages the mapping around the heads. Each head has a window of pages
+  // kept resident; pages a window leaves behind are evicted unless the
+  // other window still covers them.
+  class Pager : public Thread {
+   public:
+    Pager(DiskFrameDelay& owner, std::uint32_t framesPerPage,
+          std::uint32_t windowFrames)
+        : Thread("Delay pager"),
+          owner_(owner),
+          framesPerPage_(framesPerPage),
+          numPages_(owner.capacity_ / framesPerPage),
+          windowPages_(
+              jmin((windowFrames + framesPerPage - 1) / framesPerPage + 1,
+                   numPages_ / 4)) {}
+
+    ~Pager() override { stopThread(1000); }
+
+    void run() override {
+      std::array<Window, 2> windows{};
+      while (!threadShouldExit()) {
+        const std::array<std::uint32_t, 2> heads{
+            owner_.writeHead_.load(std::memory_order_relaxed) /
+                framesPerPage_,
+            owner_.readHead_.load(std::memory_order_relaxed) /
+                framesPerPage_};
+
+        std::array<Window, 2> next{};
+        for (auto i = 0U; i < heads.size(); ++i) {
+          next[i] = {(heads[i] + numPages_ - windowPages_) % numPages_,
+                     2 * windowPages_ + 1};
+        }
+
+        for (auto i = 0U; i < heads.size(); ++i) {
+          if (windows[i].numPages > 0) evictLeft(windows[i], next[i], next);
+          populate(next[i], i == 0);
+        }
+        windows = next;
+
+        wait(PollMilliseconds);
+      }
+    }
+
+   private:
+    static constexpr int PollMilliseconds = 5;
+
+    struct Window {
+      std::uint32_t first;
+      std::uint32_t numPages;
+
+      bool contains(std::uint32_t page, std::uint32_t ringPages) const {
+        return (page + ringPages - first) % ringPages < numPages;
+      }
+    };
+
+    void populate(const Window& window, bool forWrite) {
+      forEachRun(window.first, window.numPages,
+                 [&](std::uint32_t page, std::uint32_t count) {
+                   DiskPages::populate(pageAddress(page), count * pageBytes(),
+                                       forWrite);
+                 });
+    }
+
+    // Evicts the pages between where a window was and where it is now,
+    // unless a current window still covers them.
+    void evictLeft(const Window& from, const Window& to,
+                   const std::array<Window, 2>& current) {
+      const auto moved = (to.first + numPages_ - from.first) % numPages_;
+      if (moved == 0) return;
+
+      // Forward moves leave pages behind the window, backward moves pages
+      // ahead of it; either way the whole sweep is checked.
+      const auto forward = moved <= numPages_ / 2;
+      const auto first =
+          forward ? from.first : (to.first + to.numPages) % numPages_;
+      const auto count = jmin(
+          numPages_, forward ? moved + from.numPages
+                             : numPages_ - moved + from.numPages);
+
+      auto runStart = first;
+      std::uint32_t runLength = 0;
+      const auto flush = [&] {
+        if (runLength > 0) {
+          forEachRun(runStart, runLength,
+                     [&](std::uint32_t page, std::uint32_t n) {
+                       DiskPages::evict(pageAddress(page), n * pageBytes());
+                     });
+        }
+        runLength = 0;
+      };
+
+      for (std::uint32_t i = 0; i < count; ++i) {
+        const auto page = (first + i) % numPages_;
+        const auto keep = current[0].contains(page, numPages_) ||
+                          current[1].contains(page, numPages_);
+        if (keep) {
+          flush();
+        } else {
+          if (runLength == 0) runStart = page;
+          ++runLength;
+        }
+      }
+      flush();
+    }
+
+    // Splits a run of pages that may wrap around the end of the mapping
+    template <typename Fn>
+    void forEachRun(std::uint32_t first, std::uint32_t count, Fn fn) const {
+      const auto head = jmin(count, numPages_ - first);
+      fn(first, head);
+      if (head < count) fn(0, count - head);
+    }
+
+    void* pageAddress(std::uint32_t page) const {
+      return owner_.data_ +
+             static_cast<std::size_t>(page) * framesPerPage_ * NumChannels;
+    }
+
+    std::size_t pageBytes() const { return framesPerPage_ * sizeof(Frame); }
+
+    DiskFrameDelay& owner_;
+    const std::uint32_t framesPerPage_;
+    const std::uint32_t numPages_;
+    const std::uint32_t windowPages_;
+  };
+
+  // Whole frames throughout: a float delay stops resolving single frames
+  // past 2^24, which long lines reach
+  inline std::uint32_t frameIndex(std::uint32_t delay) const {
+    return index_ >= delay ? index_ - delay : index_ + capacity_ - delay;
+  }
+
+  std::unique_ptr<TemporaryFile> file_{};
+  std::unique_ptr<MemoryMappedFile> map_{};
+  std::unique_ptr<Pager> pager_{};
+  float* data_{};
+  std::uint32_t size_{};
+  std::uint32_t capacity_{};
+  std::uint32_t index_{};
+  // Frames written since the last clear(), up to capacity_
+  std::uint32_t written_{};
+  std::atomic<std::uint32_t> writeHead_{};
+  mutable std::atomic<std::uint32_t> readHead_{};
+};
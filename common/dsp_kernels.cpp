@@ -0,0 +1,47 @@
+#include "dsp_kernels.h"
+
+#if DSP_KERNELS_X86 && defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+#if DSP_KERNELS_X86
+// CPU support for the AVX variants, including the OS saving the wider
+// registers. GCC and Clang check both in __builtin_cpu_supports().
+#if defined(_MSC_VER)
+static bool hasOsAvxSupport(unsigned long long mask) {
+  int info[4];
+  __cpuid(info, 1);
+  const auto osxsave = (info[2] & (1 << 27)) != 0;
+  return osxsave && (_xgetbv(0) & mask) == mask;
+}
+
+static bool hasAvx2() {
+  int info[4];
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0 && hasOsAvxSupport(0x6);
+}
+
+static bool hasAvx512F() {
+  int info[4];
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 16)) != 0 && hasOsAvxSupport(0xe6);
+}
+#else
+static bool hasAvx2() { return __builtin_cpu_supports("avx2"); }
+static bool hasAvx512F() { return __builtin_cpu_supports("avx512f"); }
+#endif
+#endif
+
+static const DspKernels& selectDspKernels() {
+#if DSP_KERNELS_X86
+  if (hasAvx512F()) return DspKernelVariants::Avx512;
+  if (hasAvx2()) return DspKernelVariants::Avx2;
+#endif
+  return DspKernelVariants::Baseline;
+}
+
+const DspKernels& getDspKernels() {
+  static const DspKernels& kernels = selectDspKernels();
+  return kernels;
+}
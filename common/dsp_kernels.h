@@ -0,0 +1,39 @@
+#pragma once
+
+// Hot DSP loops, compiled once per instruction set (see CMakeLists.txt) and
+// picked at runtime by getDspKernels(). Nothing here includes JUCE: the
+// variants are built with their own instruction set flags and must not share
+// any inline code with the rest of the plugin.
+struct DspKernels {
+  // Variant name for logging: "sse2", "avx2", "avx512", "neon" or "generic"
+  const char* name;
+
+  // Block allpass: out = delayed + ffGain * in, write = in + fbGain * out
+  void (*allpass)(const float* in, const float* delayed, float* out,
+                  float* write, float ffGain, float fbGain, int numSamples);
+
+  // Stereo delay with crossed feedback. delayed and feedback hold
+  // interleaved left/right frames; feedback receives the frames to write
+  // back into the delay line, out the dry/wet mix.
+  void (*pingPong)(const float* inL, const float* inR, const float* delayed,
+                   float* feedback, float* outL, float* outR, float mix,
+                   float feedbackGain, int numSamples);
+
+  // Sparse taps panned to stereo: outL[i] is the sum over taps t of
+  // gainsL[t] * taps[t][i], outR likewise. Each tap is read as a contiguous
+  // run, so the inner loop is plain vector loads rather than gathers.
+  void (*sparseTaps)(const float* const* taps, const float* gainsL,
+                     const float* gainsR, int numTaps, float* outL,
+                     float* outR, int numSamples);
+};
+
+namespace DspKernelVariants {
+// Built with the compiler's baseline flags: SSE2 on x86-64, NEON on arm64
+extern const DspKernels Baseline;
+// Only built for x86-64, where DSP_KERNELS_X86 is set
+extern const DspKernels Avx2;
+extern const DspKernels Avx512;
+}  // namespace DspKernelVariants
+
+// The best variant for this CPU, selected on first use
+const DspKernels& getDspKernels();
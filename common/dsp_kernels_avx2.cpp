@@ -0,0 +1,5 @@
+#include "dsp_kernels.h"
+#include "dsp_kernels_impl.h"
+
+const DspKernels DspKernelVariants::Avx2{"avx2", allpass, pingPong,
+                                            sparseTaps};
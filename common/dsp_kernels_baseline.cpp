@@ -0,0 +1,14 @@
+#include "dsp_kernels.h"
+#include "dsp_kernels_impl.h"
+
+#if defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+#define DSP_KERNELS_BASELINE_NAME "neon"
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DSP_KERNELS_BASELINE_NAME "sse2"
+#else
+#define DSP_KERNELS_BASELINE_NAME "generic"
+#endif
+
+const DspKernels DspKernelVariants::Baseline{DSP_KERNELS_BASELINE_NAME,
+                                             allpass, pingPong, sparseTaps};
@@ -0,0 +1,52 @@
+#pragma once
+
+// Kernel bodies shared by the dsp_kernels_*.cpp variants. Plain loops the
+// compiler vectorizes for whatever instruction set the including file is
+// built with; internal linkage keeps each variant's copy separate.
+namespace {
+
+void allpass(const float* in, const float* delayed, float* out, float* write,
+             float ffGain, float fbGain, int numSamples) {
+  for (auto i = 0; i < numSamples; ++i) {
+    out[i] = delayed[i] + in[i] * ffGain;
+    write[i] = in[i] + out[i] * fbGain;
+  }
+}
+
+void pingPong(const float* inL, const float* inR, const float* delayed,
+              float* feedback, float* outL, float* outR, float mix,
+              float feedbackGain, int numSamples) {
+  for (auto i = 0; i < numSamples; ++i) {
+    const auto left = inL[i];
+    const auto right = inR[i];
+    const auto delayedL = delayed[2 * i];
+    const auto delayedR = delayed[2 * i + 1];
+
+    feedback[2 * i] = left + delayedR * feedbackGain;
+    feedback[2 * i + 1] = right + delayedL * feedbackGain;
+
+    outL[i] = delayedL * mix + left * (1 - mix);
+    outR[i] = delayedR * mix + right * (1 - mix);
+  }
+}
+
+void sparseTaps(const float* const* taps, const float* gainsL,
+                const float* gainsR, int numTaps, float* outL, float* outR,
+                int numSamples) {
+  for (auto i = 0; i < numSamples; ++i) {
+    outL[i] = 0.0f;
+    outR[i] = 0.0f;
+  }
+
+  for (auto t = 0; t < numTaps; ++t) {
+    const auto* tap = taps[t];
+    const auto gainL = gainsL[t];
+    const auto gainR = gainsR[t];
+    for (auto i = 0; i < numSamples; ++i) {
+      outL[i] += gainL * tap[i];
+      outR[i] += gainR * tap[i];
+    }
+  }
+}
+
+}  // namespace
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include "delay_memory_pool.h"
+
+using namespace juce;
+
+// Ring buffer of interleaved N-channel frames sharing one write index, for
+// delay lines that are always written together. A whole frame is read with
+// one load and written with one store. Reads follow Delay::read(): a delay
+// of D returns the frame written D writes ago, and write() stages a channel
+// of the next frame until advance() commits it. Each channel keeps its own
+// nominal size(); the capacity is shared. Runs of up to capacity() frames
+// are contiguous in memory.
+//
+// forget() empties the line without touching its memory, for lines too long
+// to zero on the audio thread: frames written before it read back as
+// silence through the frame reads. read() does not check, so lines read per
+// channel are emptied with clear().
+template <std::size_t NumChannels>
+class FrameDelay {
+  // Mirrored buffers are whole pages, which must hold whole frames
+  static_assert((NumChannels & (NumChannels - 1)) == 0 && NumChannels <= 64,
+                "FrameDelay needs a power-of-two channel count");
+
+ public:
+  using Frame = std::array<float, NumChannels>;
+
+  FrameDelay() = default;
+  explicit FrameDelay(std::uint32_t size) { sizes_.fill(size); }
+  explicit FrameDelay(const std::array<std::uint32_t, NumChannels>& sizes)
+      : sizes_(sizes) {}
+
+  // Takes memory from the DelayMemoryPool; see Delay::allocate()
+  inline void allocate(std::uint32_t minCapacity = 0) {
+    capacity_ = minCapacity;
+    for (auto size : sizes_) capacity_ = jmax(capacity_, size);
+    buffer_ = DelayMemoryPool::getInstance().acquire(capacity_ * NumChannels);
+    capacity_ = buffer_.size() / NumChannels;
+    index_ = 0;
+    written_ = capacity_;
+  }
+
+  inline void release() {
+    buffer_.reset();
+    capacity_ = 0;
+    index_ = 0;
+    written_ = 0;
+  }
+
+  inline void clear() {
+    buffer_.clear();
+    index_ = 0;
+    written_ = capacity_;
+  }
+
+  inline void forget() {
+    index_ = 0;
+    written_ = 0;
+  }
+
+  inline Frame readFrame(std::uint32_t delay) const {
+    Frame frame{};
+    if (delay <= written_) {
+      std::memcpy(frame.data(),
+                  buffer_.data() + frameIndex(delay) * NumChannels,
+                  sizeof(Frame));
+    }
+    return frame;
+  }
+
+  // Linear interpolation between the frames at the two nearest whole delays,
+  // for 0 <= delay < capacity(). The delay is a double so that lines past
+  // 2^24 frames still resolve between frames.
+  inline Frame readFrameInterpolated(double delay) const {
+    const auto whole = static_cast<std::uint32_t>(delay);
+    const auto frac = static_cast<float>(delay - whole);
+    const auto newer = readFrame(whole);
+    const auto older = readFrame(whole + 1);
+
+    Frame frame;
+    for (std::size_t channel = 0; channel < NumChannels; ++channel) {
+      frame[channel] =
+          newer[channel] + frac * (older[channel] - newer[channel]);
+    }
+    return frame;
+  }
+
+  inline float read(std::size_t channel, float delay) const {
+    return buffer_[frameOffset(delay) + channel];
+  }
+
+  inline void writeFrame(const Frame& frame) {
+    std::memcpy(buffer_.data() + index_ * NumChannels, frame.data(),
+                sizeof(Frame));
+    buffer_.commit(index_ * NumChannels, NumChannels);
+    advance();
+  }
+
+  inline void write(std::size_t channel, float in) {
+    buffer_.write(static_cast<std::uint32_t>(index_ * NumChannels + channel),
+                  in);
+  }
+
+  inline void advance() {
+    if (++index_ >= capacity_) index_ = 0;
+    if (written_ < capacity_) ++written_;
+  }
+
+  // Copies the next numFrames frames readFrame(delay) will return,
+  // interleaved, assuming numFrames <= delay.
+  inline void readFrames(float* out, int numFrames,
+                         std::uint32_t delay) const {
+    const auto readIndex = frameIndex(delay);
+
+    // Frames from before the last forget() lead the run
+    const auto stale = static_cast<int>(
+        jmin<std::uint32_t>(static_cast<std::uint32_t>(numFrames),
+                            delay > written_ ? delay - written_ : 0));
+    FloatVectorOperations::clear(out, stale * static_cast<int>(NumChannels));
+    FloatVectorOperations::copy(
+        out + stale * NumChannels,
+        buffer_.data() + (readIndex + stale) * NumChannels,
+        (numFrames - stale) * static_cast<int>(NumChannels));
+  }
+
+  inline void writeFrames(const float* in, int numFrames) {
+    const auto numFloats = numFrames * static_cast<int>(NumChannels);
+    FloatVectorOperations::copy(buffer_.data() + index_ * NumChannels, in,
+                                numFloats);
+    buffer_.commit(index_ * NumChannels, static_cast<std::uint32_t>(numFloats));
+    index_ += static_cast<std::uint32_t>(numFrames);
+    if (index_ >= capacity_) index_ -= capacity_;
+    written_ =
+        jmin(written_ + static_cast<std::uint32_t>(numFrames), capacity_);
+  }
+
+  inline std::uint32_t size(std::size_t channel = 0) const {
+    return sizes_[channel];
+  }
+  inline std::uint32_t capacity() const { return capacity_; }
+
+ private:
+  inline std::size_t frameOffset(float delay) const {
+    auto m = index_ - delay;
+    if (m < 0) m += capacity_;
+    return static_cast<std::size_t>(m) * NumChannels;
+  }
+
+  // The frame reads work in whole frames, exact however long the line
+  inline std::uint32_t frameIndex(std::uint32_t delay) const {
+    return index_ >= delay ? index_ - delay : index_ + capacity_ - delay;
+  }
+
+  DelayMemoryPool::Block buffer_{};
+  std::array<std::uint32_t, NumChannels> sizes_{};
+  std::uint32_t capacity_{};
+  std::uint32_t index_{};
+  // Frames written since the last forget(), up to capacity_
+  std::uint32_t written_{};
+};
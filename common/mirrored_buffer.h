@@ -0,0 +1,126 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#if JUCE_LINUX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace juce;
+
+// Ring buffer memory of size() floats followed by a mirror of itself, so any
+// run of up to size() samples starting inside the ring is contiguous and
+// needs no wrap handling. On Linux the same memfd pages are mapped twice back
+// to back and size() is rounded up to whole pages. Elsewhere, or if mapping
+// fails, the mirror is a padded copy kept in sync by write() and commit(),
+// so writes must go through those.
+class MirroredBuffer {
+ public:
+  MirroredBuffer() = default;
+
+  explicit MirroredBuffer(std::uint32_t minSize) {
+    if (minSize == 0) return;
+#if JUCE_LINUX
+    if (map(minSize)) return;
+#endif
+    size_ = minSize;
+    fallback_.resize(2 * static_cast<std::size_t>(size_));
+    data_ = fallback_.data();
+  }
+
+  MirroredBuffer(MirroredBuffer&& other) noexcept { swap(other); }
+
+  MirroredBuffer& operator=(MirroredBuffer&& other) noexcept {
+    MirroredBuffer(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  ~MirroredBuffer() {
+#if JUCE_LINUX
+    if (mapped_) munmap(data_, 2 * bytes());
+#endif
+  }
+
+  inline float* data() { return data_; }
+  inline const float* data() const { return data_; }
+  inline std::uint32_t size() const { return size_; }
+  inline bool isMapped() const { return mapped_; }
+
+  inline float& operator[](std::size_t i) { return data_[i]; }
+  inline const float& operator[](std::size_t i) const { return data_[i]; }
+
+  // Stores one sample at index < size()
+  inline void write(std::uint32_t index, float value) {
+    data_[index] = value;
+    if (!mapped_) data_[index + size_] = value;
+  }
+
+  // Call after writing numSamples <= size() samples directly at
+  // data() + start, start < size(), to bring the mirror up to date.
+  inline void commit(std::uint32_t start, std::uint32_t numSamples) {
+    if (mapped_) return;
+    const auto end = start + numSamples;
+    const auto lower = jmin(end, size_);
+    if (lower > start)
+      std::memcpy(data_ + start + size_, data_ + start,
+                  (lower - start) * sizeof(float));
+    if (end > size_)
+      std::memcpy(data_, data_ + size_, (end - size_) * sizeof(float));
+  }
+
+  inline void clear() {
+    std::fill(data_, data_ + (mapped_ ? 1 : 2) * std::size_t{size_}, 0.0f);
+  }
+
+ private:
+  inline std::size_t bytes() const { return std::size_t{size_} * sizeof(float); }
+
+  void swap(MirroredBuffer& other) noexcept {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(mapped_, other.mapped_);
+    std::swap(fallback_, other.fallback_);
+  }
+
+#if JUCE_LINUX
+  bool map(std::uint32_t minSize) {
+    const auto pageFloats =
+        static_cast<std::uint32_t>(sysconf(_SC_PAGESIZE)) / sizeof(float);
+    const auto size = (minSize + pageFloats - 1) / pageFloats * pageFloats;
+    const auto length = std::size_t{size} * sizeof(float);
+
+    const auto fd = memfd_create("delay-line", MFD_CLOEXEC);
+    if (fd < 0) return false;
+    if (ftruncate(fd, static_cast<off_t>(length)) != 0) {
+      close(fd);
+      return false;
+    }
+
+    // Reserve both halves, then map the file over each of them
+    auto* base = static_cast<char*>(mmap(nullptr, 2 * length, PROT_NONE,
+                                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    auto ok = base != MAP_FAILED;
+    for (auto half = 0; ok && half < 2; ++half) {
+      ok = mmap(base + half * length, length, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+    }
+    close(fd);
+
+    if (!ok) {
+      if (base != MAP_FAILED) munmap(base, 2 * length);
+      return false;
+    }
+
+    data_ = reinterpret_cast<float*>(base);
+    size_ = size;
+    mapped_ = true;
+    return true;
+  }
+#endif
+
+  float* data_{};
+  std::uint32_t size_{};
+  bool mapped_{};
+  std::vector<float> fallback_{};
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+using namespace juce;
+
+enum class QualityTier { Eco, Standard, High };
+
+// Tier selected by a three-step Quality parameter value
+inline QualityTier qualityTierFromValue(float value) {
+  return static_cast<QualityTier>(jlimit(0, 2, roundToInt(value * 2)));
+}
+
+// Caps the quality tier in adaptive mode: steps down one tier as soon as a
+// block takes too much of its deadline and back up after a few seconds of
+// headroom. Only reads the high resolution clock, so it is safe to use on
+// the audio thread.
+class QualityGovernor {
+ public:
+  void prepare(double sampleRate) {
+    sampleRate_ = sampleRate;
+    cap_ = QualityTier::High;
+    load_ = 0.0;
+    calmSamples_ = 0;
+  }
+
+  QualityTier getTier(QualityTier requested, bool adaptive) const {
+    return adaptive ? jmin(requested, cap_) : requested;
+  }
+
+  // Call after processing numSamples, with the ticks read before processing
+  void update(int64 startTicks, int numSamples) {
+    if (numSamples <= 0 || sampleRate_ <= 0) return;
+
+    const auto elapsed = Time::highResolutionTicksToSeconds(
+        Time::getHighResolutionTicks() - startTicks);
+    const auto load = elapsed * sampleRate_ / numSamples;
+
+    // Follow peaks at once, fall back slowly
+    load_ = load > load_ ? load : load_ + 0.05 * (load - load_);
+
+    if (load_ > StepDownLoad) {
+      if (cap_ != QualityTier::Eco) {
+        cap_ = static_cast<QualityTier>(static_cast<int>(cap_) - 1);
+        load_ = 0.0;
+      }
+      calmSamples_ = 0;
+    } else if (load_ < StepUpLoad) {
+      calmSamples_ += numSamples;
+      if (calmSamples_ > StepUpSeconds * sampleRate_ &&
+          cap_ != QualityTier::High) {
+        cap_ = static_cast<QualityTier>(static_cast<int>(cap_) + 1);
+        calmSamples_ = 0;
+      }
+    } else {
+      calmSamples_ = 0;
+    }
+  }
+
+  QualityTier getCap() const { return cap_; }
+
+ private:
+  // Fractions of the block deadline
+  static constexpr double StepDownLoad = 0.75;
+  static constexpr double StepUpLoad = 0.25;
+  static constexpr double StepUpSeconds = 3.0;
+
+  double sampleRate_{};
+  QualityTier cap_{QualityTier::High};
+  double load_{};
+  double calmSamples_{};
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include <atomic>
+#include <functional>
+
+#if JUCE_LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace juce;
+
+// Runs one processing stage on a dedicated real-time thread. The audio
+// thread starts the stage with kick() and collects it with wait() before the
+// next kick(); the handover itself only uses atomics. If the thread could not
+// be started the stage runs inline in kick(), and if the thread has not
+// picked the stage up by the time wait() gives up spinning, wait() runs it
+// inline instead. Only a stage the thread is already running is waited for.
+// On Linux the idle thread sleeps on a futex on the state itself, so waking
+// it takes no lock. Elsewhere it sleeps on a WaitableEvent, whose signal()
+// briefly takes a mutex on the audio thread; the deliberate exception there.
+class StageWorker : private Thread {
+ public:
+  explicit StageWorker(std::function<void()> stage)
+      : Thread("Stage worker"), stage_(std::move(stage)) {}
+
+  ~StageWorker() override { stop(); }
+
+  bool start() { return startRealtimeThread(RealtimeOptions{}); }
+
+  void stop() {
+    signalThreadShouldExit();
+    wakeThread();
+    stopThread(1000);
+  }
+
+  void kick() {
+    if (!isThreadRunning()) {
+      stage_();
+      return;
+    }
+
+    state_.store(Pending, std::memory_order_release);
+    wakeThread();
+  }
+
+  void wait() {
+    for (auto spin = 0; spin < MaxWaitSpins; ++spin) {
+      if (state_.load(std::memory_order_acquire) == Idle) return;
+      std::this_thread::yield();
+    }
+
+    // The thread is late: take the stage back if it has not started it
+    if (claim()) {
+      stage_();
+      state_.store(Idle, std::memory_order_release);
+      return;
+    }
+
+    while (state_.load(std::memory_order_acquire) != Idle) {
+      std::this_thread::yield();
+    }
+  }
+
+ private:
+  static constexpr int MaxWaitSpins = 64;
+
+  enum State { Idle, Pending, Running };
+
+  // Moves a pending stage to running, for whichever thread gets there first
+  bool claim() {
+    auto expected = static_cast<int>(Pending);
+    return state_.compare_exchange_strong(expected, Running,
+                                          std::memory_order_acquire);
+  }
+
+  void run() override {
+    while (!threadShouldExit()) {
+      if (!claim()) {
+        sleepWhileIdle();
+        continue;
+      }
+
+      stage_();
+      state_.store(Idle, std::memory_order_release);
+    }
+  }
+
+#if JUCE_LINUX
+  static_assert(sizeof(std::atomic<int>) == sizeof(int) &&
+                std::atomic<int>::is_always_lock_free);
+
+  // Returns at once if a kick() already moved the state off Idle
+  void sleepWhileIdle() {
+    const timespec timeout{0, 100 * 1000 * 1000};
+    syscall(SYS_futex, reinterpret_cast<int*>(&state_), FUTEX_WAIT_PRIVATE,
+            static_cast<int>(Idle), &timeout, nullptr, 0);
+  }
+
+  void wakeThread() {
+    syscall(SYS_futex, reinterpret_cast<int*>(&state_), FUTEX_WAKE_PRIVATE, 1,
+            nullptr, nullptr, 0);
+  }
+#else
+  void sleepWhileIdle() { wake_.wait(100); }
+
+  void wakeThread() { wake_.signal(); }
+
+  WaitableEvent wake_{};
+#endif
+
+  std::function<void()> stage_;
+  std::atomic<int> state_{Idle};
+};
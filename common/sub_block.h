@@ -0,0 +1,18 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+using namespace juce;
+
+// Longest run the processors work through their scratch buffers at once:
+// long enough to spread the per-run setup, short enough for the scratch
+// buffers to stay in L1 cache whatever block size the host sends.
+constexpr int MaxSubBlockSize = 256;
+
+// Calls fn(offset, n) for consecutive runs of at most maxRun of numSamples
+template <typename Fn>
+inline void forEachSubBlock(int numSamples, int maxRun, Fn fn) {
+  for (auto offset = 0; offset < numSamples; offset += maxRun) {
+    fn(offset, jmin(maxRun, numSamples - offset));
+  }
+}
@@ -10,6 +10,7 @@ DelayAudioProcessorEditor::DelayAudioProcessorEditor(
   knobs_[DelayParameters::Mix] = std::make_shared<Knob>("Mix");
   knobs_[DelayParameters::Time] = std::make_shared<Knob>("Time");
   knobs_[DelayParameters::Feedback] = std::make_shared<Knob>("Feedback");
+  knobs_[DelayParameters::Quality] = std::make_shared<Knob>("Quality");
 
   addAndMakeVisible(titleLabel_);
   titleLabel_.setColour(Label::textColourId, Colours::silver);
@@ -17,7 +18,9 @@ DelayAudioProcessorEditor::DelayAudioProcessorEditor(
   titleLabel_.setJustificationType(Justification::horizontallyCentred);
   titleLabel_.setText("D E L A Y", dontSendNotification);
 
+  // Parameters without a knob are left to the host
   for (auto i = 0U; i < DelayParameters::End; ++i) {
+    if (knobs_[i] == nullptr) continue;
     addAndMakeVisible(*knobs_[i]);
     knobs_[i]->getSlider().addListener(this);
     knobs_[i]->getSlider().setValue(processor_.getParameters()[i]->getValue());
@@ -42,6 +45,7 @@ void DelayAudioProcessorEditor::resized() {
   fb.justifyContent = juce::FlexBox::JustifyContent::center;
 
   for (auto& knob : knobs_) {
+    if (knob == nullptr) continue;
     fb.items.add(FlexItem(getWidth() / 10, getHeight() / 5, *knob).withMargin(30.0f));
   }
 
@@ -58,5 +62,8 @@ void DelayAudioProcessorEditor::sliderValueChanged(Slider* slider) {
   } else if (slider == &knobs_[DelayParameters::Feedback]->getSlider()) {
     processor_.getParameters()[DelayParameters::Feedback]->setValueNotifyingHost(
         slider->getValue());
+  } else if (slider == &knobs_[DelayParameters::Quality]->getSlider()) {
+    processor_.getParameters()[DelayParameters::Quality]->setValueNotifyingHost(
+        slider->getValue());
   }
 }
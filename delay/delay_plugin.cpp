@@ -0,0 +1,26 @@
+#include "delay_processor.h"
+
+#if !HEADLESS_PLUGIN
+#include "delay_editor.h"
+#endif
+
+// The processor from the delay_dsp library with what depends on the plugin
+// target: its name and, unless built headless, its editor.
+class DelayPlugin : public DelayAudioProcessor {
+ public:
+  const juce::String getName() const override { return JucePlugin_Name; }
+
+#if !HEADLESS_PLUGIN
+  bool hasEditor() const override { return true; }
+
+  juce::AudioProcessorEditor* createEditor() override {
+    return new DelayAudioProcessorEditor(*this);
+  }
+#endif
+};
+
+//==============================================================================
+// This creates new instances of the plugin..
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter() {
+  return new DelayPlugin();
+}
@@ -1,7 +1,5 @@
 #include "delay_processor.h"
 
-#include "delay_editor.h"
-
 //==============================================================================
 DelayAudioProcessor::DelayAudioProcessor()
     : AudioProcessor(
@@ -14,19 +12,19 @@ DelayAudioProcessor::DelayAudioProcessor()
 #endif
       ) {
   parameters_.resize(DelayParameters::End);
-  addParameter(parameters_[DelayParameters::Mix] = new DelayParam("Mix", 0.3f));
-  addParameter(parameters_[DelayParameters::Time] =
-                   new DelayParam("Time", 0.5f));
-  addParameter(parameters_[DelayParameters::Feedback] =
-                   new DelayParam("Feedback", 0.3f));
+  for (auto i = 0U; i < DelayParameters::End; ++i) {
+    const auto& spec = DelayParameterSpecs[i];
+    addParameter(parameters_[i] = new DelayParam(spec.name, spec.defaultValue,
+                                                 spec.numSteps));
+  }
 }
 
 DelayAudioProcessor::~DelayAudioProcessor() {}
 
 //==============================================================================
-const juce::String DelayAudioProcessor::getName() const {
-  return JucePlugin_Name;
-}
+// The plugin target reports its own name and adds the editor, see
+// delay_plugin.cpp
+const juce::String DelayAudioProcessor::getName() const { return "Delay"; }
 
 bool DelayAudioProcessor::acceptsMidi() const {
 #if JucePlugin_WantsMidiInput
@@ -52,7 +50,18 @@ bool DelayAudioProcessor::isMidiEffect() const {
 #endif
 }
 
-double DelayAudioProcessor::getTailLengthSeconds() const { return 0.0; }
+// The echoes ring until feedback has taken them 60 dB down
+double DelayAudioProcessor::getTailLengthSeconds() const {
+  const auto feedback = parameters_[DelayParameters::Feedback]->getValue();
+  if (feedback >= 1.0f) return std::numeric_limits<double>::infinity();
+
+  const auto repeats =
+      feedback > 0.0f ? 1.0 + std::ceil(std::log(0.001) / std::log(feedback))
+                      : 1.0;
+  const auto maxSeconds =
+      longDelayMode_ ? MaxLongDelaySeconds : MaxDelaySeconds;
+  return repeats * getTimeValue() * maxSeconds;
+}
 
 int DelayAudioProcessor::getNumPrograms() {
   return 1;  // NB: some hosts don't cope very well if you tell them there are 0
@@ -81,15 +90,50 @@ void DelayAudioProcessor::prepareToPlay(double sampleRate,
                                         int samplesPerBlock) {
   // Use this method as the place to do any pre-playback
   // initialisation that you need..
-  juce::ignoreUnused(samplesPerBlock);
+  // Long delay mode is picked up here, as it swaps the delay line. If the
+  // backing file cannot be set up, the plugin runs the normal line instead.
+  // Only the line in use holds memory, and the file only exists while long
+  // delay mode runs.
+  longDelayMode_ = false;
+  if (parameters_[DelayParameters::LongDelay]->getValue() >= 0.5f) {
+    const auto length = static_cast<std::uint32_t>(
+        std::ceil(MaxLongDelaySeconds * sampleRate));
+    const auto window =
+        static_cast<std::uint32_t>(LongDelayWindowSeconds * sampleRate);
+    longDelayMode_ = longDelay_.allocate(length, window);
+  }
+  if (longDelayMode_) {
+    delay_.release();
+  } else {
+    longDelay_.release();
+    const auto length =
+        static_cast<std::uint32_t>(std::ceil(MaxDelaySeconds * sampleRate));
+    delay_ = FrameDelay<2>(length);
+    delay_.allocate();
+  }
+
+  // Scratch only ever holds one sub-block
+  maxBlockSize_ = jmax(1, samplesPerBlock);
+  for (auto& scratch : scratch_) {
+    scratch.assign(
+        2 * static_cast<size_t>(jmin(maxBlockSize_, MaxSubBlockSize)),
+        0.0f);
+  }
+
+  governor_.prepare(sampleRate);
+  bypass_.prepare(sampleRate, samplesPerBlock,
+                  parameters_[DelayParameters::Bypass]->getValue() >= 0.5f);
 
   std::cout << "Sample rate: " << sampleRate << std::endl;
-  currentTime_ = parameters_[DelayParameters::Time]->getValue();
+  currentTime_ = getTimeValue();
+  glideStep_ = longDelayMode_
+                   ? GlideStep * MaxDelaySeconds / MaxLongDelaySeconds
+                   : GlideStep;
 }
 
 void DelayAudioProcessor::releaseResources() {
-  // When playback stops, you can use this as an opportunity to free up any
-  // spare memory, etc.
+  delay_.release();
+  longDelay_.release();
 }
 
 bool DelayAudioProcessor::isBusesLayoutSupported(
@@ -114,80 +158,228 @@ bool DelayAudioProcessor::isBusesLayoutSupported(
 #endif
 }
 
-void DelayAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer,
-                                       juce::MidiBuffer& midiMessages) {
-  juce::ignoreUnused(midiMessages);
-
-  juce::ScopedNoDenormals noDenormals;
+std::uint32_t DelayAudioProcessor::delaySamples(std::uint32_t length,
+                                                double time) {
+  const auto delay = std::ceil(length * time - 1);
+  return static_cast<std::uint32_t>(
+      jlimit(1.0, static_cast<double>(length), delay));
+}
 
-  auto mix = parameters_[DelayParameters::Mix]->getValue();
-  auto time = parameters_[DelayParameters::Time]->getValue();
-  auto feedback = parameters_[DelayParameters::Feedback]->getValue();
+// The feedback lag equals the delay time, so a chunk no longer than the delay
+// only reads samples written before it and can be moved as whole blocks.
+template <typename DelayLine>
+void DelayAudioProcessor::processChunk(DelayLine& line, const float* inL,
+                                       const float* inR, float* outL,
+                                       float* outR, int numSamples,
+                                       std::uint32_t delay, float mix,
+                                       float feedback) {
+  auto* delayed = scratch_[0].data();
+  auto* feedbackFrames = scratch_[1].data();
+
+  line.readFrames(delayed, numSamples, delay);
+  kernels_.pingPong(inL, inR, delayed, feedbackFrames, outL, outR, mix,
+                    feedback, numSamples);
+  line.writeFrames(feedbackFrames, numSamples);
+}
 
-  auto num_samples = buffer.getNumSamples();
-  auto inL = buffer.getReadPointer(0);
-  auto inR = buffer.getReadPointer(1);
-  auto outL = buffer.getWritePointer(0);
-  auto outR = buffer.getWritePointer(1);
+// Runs the delay over one stretch of samples on either delay line
+template <typename DelayLine>
+void DelayAudioProcessor::processSamples(DelayLine& line, const float* inL,
+                                         const float* inR, float* outL,
+                                         float* outR, int numSamples,
+                                         float mix, double time,
+                                         float feedback, QualityTier tier) {
+  while (numSamples > 0) {
+    const auto delay = delaySamples(line.size(), currentTime_);
+
+    // Settled on the target time, or gliding in eco quality: move a whole
+    // chunk at once, stepping the time once per chunk
+    const auto settled = currentTime_ == time && delay >= MinChunkDelay;
+    if (settled || tier == QualityTier::Eco) {
+      auto n = jmin(numSamples, static_cast<int>(delay),
+                    static_cast<int>(scratch_[0].size() / 2));
+      if (!settled) n = jmin(n, EcoGlideChunk);
+
+      processChunk(line, inL, inR, outL, outR, n, delay, mix, feedback);
+      inL += n;
+      inR += n;
+      outL += n;
+      outR += n;
+      numSamples -= n;
+
+      if (currentTime_ < time) {
+        currentTime_ = jmin(currentTime_ + n * glideStep_, time);
+      } else if (currentTime_ > time) {
+        currentTime_ = jmax(currentTime_ - n * glideStep_, time);
+      }
+      continue;
+    }
 
-  while (num_samples--) {
+    // Gliding towards a new time, or a very short delay: one sample at a time
     if (currentTime_ < time) {
-      currentTime_ += 0.000005f;
+      currentTime_ = jmin(currentTime_ + glideStep_, time);
     } else if (currentTime_ > time) {
-      currentTime_ -= 0.000005f;
+      currentTime_ = jmax(currentTime_ - glideStep_, time);
     }
 
     auto left = *inL++;
     auto right = *inR++;
 
-    auto delayedL = delayLeft_.read(delayLeft_.size() * currentTime_ - 1);
-    auto delayedR = delayRight_.read(delayRight_.size() * currentTime_ - 1);
+    // High quality reads between samples while the time glides
+    const auto [delayedL, delayedR] =
+        tier == QualityTier::High
+            ? line.readFrameInterpolated(
+                  jlimit(1.0, line.size() - 1.0,
+                         line.size() * currentTime_ - 1))
+            : line.readFrame(delaySamples(line.size(), currentTime_));
 
-    delayLeft_.write(left + delayedR * feedback);
-    delayRight_.write(right + delayedL * feedback);
+    line.writeFrame({left + delayedR * feedback, right + delayedL * feedback});
 
     *outL++ = delayedL * mix + left * (1 - mix);
     *outR++ = delayedR * mix + right * (1 - mix);
+    --numSamples;
   }
 }
 
-//==============================================================================
-bool DelayAudioProcessor::hasEditor() const {
-  return true;  // (change this to false if you choose to not supply an editor)
+void DelayAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer,
+                                       juce::MidiBuffer& midiMessages) {
+  juce::ignoreUnused(midiMessages);
+
+  process(buffer.getReadPointer(0), buffer.getReadPointer(1),
+          buffer.getWritePointer(0), buffer.getWritePointer(1),
+          buffer.getNumSamples());
+}
+
+void DelayAudioProcessor::processBlockBypassed(
+    juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) {
+  juce::ignoreUnused(midiMessages);
+
+  const auto* inL = buffer.getReadPointer(0);
+  const auto* inR = buffer.getReadPointer(1);
+  auto* outL = buffer.getWritePointer(0);
+  auto* outR = buffer.getWritePointer(1);
+  forEachSubBlock(buffer.getNumSamples(), maxBlockSize_,
+                  [&](int offset, int n) {
+                    processWithBypass(inL + offset, inR + offset,
+                                      outL + offset, outR + offset, n, true);
+                  });
+}
+
+void DelayAudioProcessor::process(const float* inL, const float* inR,
+                                  float* outL, float* outR, int numSamples) {
+  const auto bypass = parameters_[DelayParameters::Bypass]->getValue() >= 0.5f;
+  forEachSubBlock(numSamples, maxBlockSize_, [&](int offset, int n) {
+    processWithBypass(inL + offset, inR + offset, outL + offset,
+                      outR + offset, n, bypass);
+  });
+}
+
+// Fully bypassed, the input is passed on and the delay line is left alone
+void DelayAudioProcessor::processWithBypass(const float* inL, const float* inR,
+                                            float* outL, float* outR,
+                                            int numSamples, bool bypass) {
+  juce::ScopedNoDenormals noDenormals;
+
+  switch (bypass_.getStage(bypass)) {
+    case BypassFade::Stage::Active:
+      processActive(inL, inR, outL, outR, numSamples);
+      break;
+
+    case BypassFade::Stage::Fading:
+      if (bypass_.leaveBypassed()) {
+        currentTime_ = getTimeValue();
+      }
+      FloatVectorOperations::copy(bypass_.getDry(0), inL, numSamples);
+      FloatVectorOperations::copy(bypass_.getDry(1), inR, numSamples);
+      processActive(inL, inR, outL, outR, numSamples);
+      bypass_.fade(outL, outR, numSamples, bypass);
+      break;
+
+    case BypassFade::Stage::Bypassed:
+      if (bypass_.enterBypassed()) {
+        // Both lines forget their contents without touching them, as
+        // zeroing seconds of audio would stall the audio thread
+        if (longDelayMode_) {
+          longDelay_.clear();
+        } else {
+          delay_.forget();
+        }
+      }
+      if (outL != inL) FloatVectorOperations::copy(outL, inL, numSamples);
+      if (outR != inR) FloatVectorOperations::copy(outR, inR, numSamples);
+      break;
+  }
+}
+
+void DelayAudioProcessor::processActive(const float* inL, const float* inR,
+                                        float* outL, float* outR,
+                                        int numSamples) {
+  auto mix = parameters_[DelayParameters::Mix]->getValue();
+  auto time = getTimeValue();
+  auto feedback = parameters_[DelayParameters::Feedback]->getValue();
+
+  const auto adaptive =
+      parameters_[DelayParameters::Adaptive]->getValue() >= 0.5f;
+  // The clock is only read for the governor
+  const auto startTicks = adaptive ? Time::getHighResolutionTicks() : 0;
+  const auto tier = governor_.getTier(
+      qualityTierFromValue(parameters_[DelayParameters::Quality]->getValue()),
+      adaptive);
+
+  if (longDelayMode_) {
+    processSamples(longDelay_, inL, inR, outL, outR, numSamples, mix, time,
+                   feedback, tier);
+  } else {
+    processSamples(delay_, inL, inR, outL, outR, numSamples, mix, time,
+                   feedback, tier);
+  }
+
+  if (adaptive) governor_.update(startTicks, numSamples);
+}
+
+// The delay time as a fraction of the line in use
+float DelayAudioProcessor::getTimeValue() const {
+  return parameters_[longDelayMode_ ? DelayParameters::LongTime
+                                    : DelayParameters::Time]
+      ->getValue();
+}
+
+AudioProcessorParameter* DelayAudioProcessor::getBypassParameter() const {
+  return parameters_[DelayParameters::Bypass];
 }
 
+//==============================================================================
+bool DelayAudioProcessor::hasEditor() const { return false; }
+
 juce::AudioProcessorEditor* DelayAudioProcessor::createEditor() {
-  return new DelayAudioProcessorEditor(*this);
+  return nullptr;
 }
 
 //==============================================================================
 void DelayAudioProcessor::getStateInformation(juce::MemoryBlock& destData) {
-  std::unique_ptr<juce::XmlElement> xml(new juce::XmlElement("Delay"));
-  xml->setAttribute("Mix", parameters_[DelayParameters::Mix]->getValue());
-  xml->setAttribute("Time", parameters_[DelayParameters::Time]->getValue());
-  xml->setAttribute("Feedback", parameters_[DelayParameters::Feedback]->getValue());
-  copyXmlToBinary(*xml, destData);
+  BinaryState::write(destData, StateTag, parameters_);
 }
 
 void DelayAudioProcessor::setStateInformation(const void* data,
                                               int sizeInBytes) {
+  if (BinaryState::read(data, sizeInBytes, StateTag, parameters_) !=
+      BinaryState::ReadResult::NotBinary)
+    return;
+
+  // States saved before the binary format are XML
   std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
 
   if (xmlState.get() != nullptr)
     if (xmlState->hasTagName("Delay"))
     {
-      parameters_[DelayParameters::Mix]->setValue(xmlState->getDoubleAttribute("Mix", 0.3));
-      parameters_[DelayParameters::Time]->setValue(xmlState->getDoubleAttribute("Time", 0.5));
-      parameters_[DelayParameters::Feedback]->setValue(xmlState->getDoubleAttribute("Feedback", 0.3));
+      for (auto i = 0U; i < DelayParameters::End; ++i) {
+        const auto& spec = DelayParameterSpecs[i];
+        parameters_[i]->setValue(
+            xmlState->getDoubleAttribute(spec.key, spec.defaultValue));
+      }
     }
 }
 
 std::vector<AudioProcessorParameter*> DelayAudioProcessor::getParameters() {
   return parameters_;
 }
-
-//==============================================================================
-// This creates new instances of the plugin..
-juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter() {
-  return new DelayAudioProcessor();
-}
@@ -2,46 +2,44 @@
 
 #include <juce_audio_processors/juce_audio_processors.h>
 
+#include "binary_state.h"
+#include "bypass_fade.h"
+#include "disk_delay.h"
+#include "dsp_kernels.h"
+#include "frame_delay.h"
+#include "quality_governor.h"
+#include "sub_block.h"
+
 using namespace juce;
 
-enum DelayParameters {
+namespace DelayParameters {
+enum Parameter {
   Mix,
   Time,
   Feedback,
+  Quality,
+  Adaptive,
+  LongDelay,
+  Bypass,
+  LongTime,
   End
 };
-
-class Delay {
- public:
-  Delay(std::uint32_t size) : size_(size) {
-    buffer_.resize(size);
-    std::fill(buffer_.begin(), buffer_.end(), 0);
-  }
-
-  inline float read(float delay) const {
-    auto m = index_ - delay;
-    if (m < 0) m += size_;
-
-    return buffer_[m];
-  }
-
-  inline void write(float in) {
-    buffer_[index_++] = in;
-    if (index_ >= size_) index_ = 0;
-  }
-
-  inline std::uint32_t size() const { return size_; }
-
- private:
-  std::vector<float> buffer_;
-  std::uint32_t size_{};
-  std::uint32_t index_{};
-};
+}  // namespace DelayParameters
+
+constexpr ParameterSpec DelayParameterSpecs[DelayParameters::End] = {
+    {"Mix", "Mix", 0.3f},
+    {"Time", "Time", 0.5f},
+    {"Feedback", "Feedback", 0.3f},
+    {"Quality", "Quality", 0.5f, 3},
+    {"Adaptive", "Adaptive quality", 0.0f, 2},
+    {"LongDelay", "Long delay", 0.0f, 2},
+    {"Bypass", "Bypass", 0.0f, 2},
+    {"LongTime", "Long delay time", 0.1f}};
 
 class DelayParam : public AudioProcessorParameter {
  public:
-  DelayParam(const String& name, float defaultValue)
-      : name_(name), defaultValue_(defaultValue) {
+  DelayParam(const String& name, float defaultValue, int numSteps = 0)
+      : name_(name), defaultValue_(defaultValue), numSteps_(numSteps) {
     value_.store(defaultValue);
   }
 
@@ -49,7 +47,7 @@ class DelayParam : public AudioProcessorParameter {
 
   void setValue(float v) override { value_.store(v); }
 
-  float getDefaultValue() const override { return 0.5f; }
+  float getDefaultValue() const override { return defaultValue_; }
 
   String getName(int maximumStringLength) const override { return name_; }
 
@@ -57,8 +55,18 @@ class DelayParam : public AudioProcessorParameter {
 
   float getValueForText(const String& text) const override { return 0.0f; }
 
+  int getNumSteps() const override {
+    return numSteps_ > 0 ? numSteps_
+                         : AudioProcessor::getDefaultNumParameterSteps();
+  }
+
+  bool isDiscrete() const override { return numSteps_ > 0; }
+
+  bool isBoolean() const override { return numSteps_ == 2; }
+
   String name_;
   float defaultValue_;
+  int numSteps_;
   std::atomic<float> value_;
 };
 
@@ -76,6 +84,15 @@ class DelayAudioProcessor : public juce::AudioProcessor {
   bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
 
   void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+  void processBlockBypassed(juce::AudioBuffer<float>&,
+                            juce::MidiBuffer&) override;
+
+  // processBlock() on plain stereo channel pointers. in and out may be the
+  // same buffers.
+  void process(const float* inL, const float* inR, float* outL, float* outR,
+               int numSamples);
+
+  AudioProcessorParameter* getBypassParameter() const override;
 
   //==============================================================================
   juce::AudioProcessorEditor* createEditor() override;
@@ -102,11 +119,60 @@ class DelayAudioProcessor : public juce::AudioProcessor {
 
   std::vector<AudioProcessorParameter*> getParameters();
 
+  // Name of the DSP kernel variant this instance runs, for logging
+  const char* getKernelVariant() const { return kernels_.name; }
+
  private:
+  static constexpr char StateTag[5] = "DLAY";
+
+  // Longest delay, the original fixed 102400-sample line at 48 kHz
+  static constexpr double MaxDelaySeconds = 102400.0 / 48000.0;
+
+  // Below this many samples of delay a chunk is too short to pay off.
+  static constexpr std::uint32_t MinChunkDelay = 16;
+  // Longest chunk eco quality glides the delay time over in one step
+  static constexpr int EcoGlideChunk = 32;
+
+  // Longest delay in long delay mode, where the line lives on disk. Long
+  // delay mode has its own time parameter over this range, so that Time
+  // keeps its meaning whichever mode runs.
+  static constexpr double MaxLongDelaySeconds = 600.0;
+  // Audio kept resident around each head of the disk backed line
+  static constexpr double LongDelayWindowSeconds = 0.5;
+
+  // Time change per sample while gliding towards a new time, on the normal
+  // line. The long line glides over the same seconds per second.
+  static constexpr double GlideStep = 0.000005;
+
+  static std::uint32_t delaySamples(std::uint32_t length, double time);
+  template <typename DelayLine>
+  void processChunk(DelayLine& line, const float* inL, const float* inR,
+                    float* outL, float* outR, int numSamples,
+                    std::uint32_t delay, float mix, float feedback);
+  template <typename DelayLine>
+  void processSamples(DelayLine& line, const float* inL, const float* inR,
+                      float* outL, float* outR, int numSamples, float mix,
+                      double time, float feedback, QualityTier tier);
+  void processWithBypass(const float* inL, const float* inR, float* outL,
+                         float* outR, int numSamples, bool bypass);
+  void processActive(const float* inL, const float* inR, float* outL,
+                     float* outR, int numSamples);
+  float getTimeValue() const;
+
   std::vector<AudioProcessorParameter*> parameters_{};
-  float currentTime_{};
-  Delay delayLeft_{1024 * 100};
-  Delay delayRight_{1024 * 100};
+  const DspKernels& kernels_{getDspKernels()};
+  // Double, as a float time stops resolving single samples on the long line
+  double currentTime_{};
+  double glideStep_{GlideStep};
+  FrameDelay<2> delay_{};
+  // Used instead of delay_ in long delay mode
+  DiskFrameDelay<2> longDelay_{};
+  bool longDelayMode_{};
+  QualityGovernor governor_{};
+  std::array<std::vector<float>, 2> scratch_{};
+  BypassFade bypass_{};
+  // Prepared block size; longer host blocks are split into runs of this
+  int maxBlockSize_{1};
 
   //==============================================================================
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DelayAudioProcessor)
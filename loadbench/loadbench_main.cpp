@@ -0,0 +1,243 @@
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+
+#if JUCE_LINUX
+#include <unistd.h>
+
+#include <fstream>
+#elif JUCE_MAC
+#include <mach/mach.h>
+#elif JUCE_WINDOWS
+#include <windows.h>
+// windows.h first
+#include <psapi.h>
+#pragma comment(lib, "psapi")
+#endif
+
+using namespace juce;
+
+// Loads the built VST3 binaries the way a host loads a session and times
+// what each instance costs: scanning the binary, creating instances,
+// prepareToPlay, saving and restoring state and creating the editor. Memory
+// is the growth of the process' resident set, per instance.
+//
+// Usage: loadbench [--instances N] [plugin.vst3 ...]
+//
+// Without paths, the delay and reverb2 VST3s of this build are loaded.
+
+namespace {
+
+constexpr double SampleRate = 48000.0;
+constexpr int BlockSize = 512;
+
+struct Options {
+  int instances = 200;
+  StringArray paths;
+};
+
+// Resident set size of this process, 0 where unknown
+int64 getResidentBytes() {
+#if JUCE_LINUX
+  std::ifstream statm("/proc/self/statm");
+  int64 pages = 0;
+  int64 residentPages = 0;
+  statm >> pages >> residentPages;
+  return residentPages * sysconf(_SC_PAGESIZE);
+#elif JUCE_MAC
+  mach_task_basic_info info{};
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                reinterpret_cast<task_info_t>(&info),
+                &count) != KERN_SUCCESS)
+    return 0;
+  return static_cast<int64>(info.resident_size);
+#elif JUCE_WINDOWS
+  PROCESS_MEMORY_COUNTERS counters{};
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    return 0;
+  return static_cast<int64>(counters.WorkingSetSize);
+#else
+  return 0;
+#endif
+}
+
+// Times one step per instance
+class StepTimes {
+ public:
+  explicit StepTimes(const char* name) : name_(name) {}
+
+  template <typename Fn>
+  void time(Fn&& fn) {
+    const auto startTicks = Time::getHighResolutionTicks();
+    fn();
+    milliseconds_.push_back(1000.0 * Time::highResolutionTicksToSeconds(
+                                         Time::getHighResolutionTicks() -
+                                         startTicks));
+  }
+
+  void print() const {
+    std::cout << "  " << String(name_).paddedRight(' ', 14);
+    if (milliseconds_.empty()) {
+      std::cout << "-\n";
+      return;
+    }
+
+    auto sorted = milliseconds_;
+    std::sort(sorted.begin(), sorted.end());
+    const auto total = std::accumulate(sorted.begin(), sorted.end(), 0.0);
+    std::cout << "mean " << format(total / sorted.size()) << "  p50 "
+              << format(sorted[sorted.size() / 2]) << "  max "
+              << format(sorted.back()) << "  total " << format(total) << "\n";
+  }
+
+ private:
+  static String format(double milliseconds) {
+    return String(milliseconds, 3) + " ms";
+  }
+
+  const char* name_;
+  std::vector<double> milliseconds_;
+};
+
+String formatBytes(int64 bytes) {
+  return String(static_cast<double>(bytes) / 1024.0, 1) + " KB";
+}
+
+// Runs every step over options.instances instances of the plugin at path.
+// Returns false if the plugin could not be loaded.
+bool benchmark(AudioPluginFormat& format, const String& path,
+               const Options& options) {
+  std::cout << "\n" << path << "\n";
+
+  OwnedArray<PluginDescription> types;
+  StepTimes scan("scan");
+  scan.time([&] { format.findAllTypesForFile(types, path); });
+  if (types.isEmpty()) {
+    std::cout << "  no plugin found\n";
+    return false;
+  }
+  const auto& description = *types.getFirst();
+  std::cout << "  " << description.name << " " << description.version << "\n";
+
+  std::vector<std::unique_ptr<AudioPluginInstance>> instances;
+  instances.reserve(static_cast<size_t>(options.instances));
+  StepTimes instantiate("instantiate");
+  StepTimes prepare("prepare");
+  StepTimes saveState("save state");
+  StepTimes restoreState("restore state");
+  StepTimes createEditor("editor");
+  StepTimes release("release");
+
+  const auto residentBefore = getResidentBytes();
+  for (auto i = 0; i < options.instances; ++i) {
+    String error;
+    std::unique_ptr<AudioPluginInstance> instance;
+    instantiate.time([&] {
+      instance = format.createInstanceFromDescription(description, SampleRate,
+                                                      BlockSize, error);
+    });
+    if (instance == nullptr) {
+      std::cout << "  instance " << i << " failed: " << error << "\n";
+      return false;
+    }
+    instances.push_back(std::move(instance));
+  }
+  const auto residentCreated = getResidentBytes();
+
+  for (auto& instance : instances) {
+    prepare.time([&] { instance->prepareToPlay(SampleRate, BlockSize); });
+  }
+  const auto residentPrepared = getResidentBytes();
+
+  for (auto& instance : instances) {
+    MemoryBlock state;
+    saveState.time([&] { instance->getStateInformation(state); });
+    restoreState.time([&] {
+      instance->setStateInformation(state.getData(),
+                                    static_cast<int>(state.getSize()));
+    });
+  }
+
+  // Headless builds have no editor to time
+  for (auto& instance : instances) {
+    if (!instance->hasEditor()) continue;
+
+    std::unique_ptr<AudioProcessorEditor> editor;
+    createEditor.time([&] { editor.reset(instance->createEditorIfNeeded()); });
+  }
+
+  for (auto& instance : instances) {
+    release.time([&] {
+      instance->releaseResources();
+      instance.reset();
+    });
+  }
+
+  scan.print();
+  instantiate.print();
+  prepare.print();
+  saveState.print();
+  restoreState.print();
+  createEditor.print();
+  release.print();
+
+  const auto numInstances = static_cast<int64>(instances.size());
+  std::cout << "  memory        "
+            << formatBytes((residentCreated - residentBefore) / numInstances)
+            << " per instance, "
+            << formatBytes((residentPrepared - residentBefore) / numInstances)
+            << " once prepared\n";
+  return true;
+}
+
+Options parseOptions(const StringArray& args) {
+  Options options;
+  for (auto i = 0; i < args.size(); ++i) {
+    if (args[i] == "--instances" && i + 1 < args.size()) {
+      options.instances = jmax(1, args[++i].getIntValue());
+    } else {
+      options.paths.add(args[i]);
+    }
+  }
+
+  if (options.paths.isEmpty()) {
+    options.paths.add(DELAY_VST3_PATH);
+    options.paths.add(REVERB2_VST3_PATH);
+  }
+  return options;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  // Plugins expect a message thread; this one is it
+  ScopedJuceInitialiser_GUI juceInitialiser;
+
+  StringArray args;
+  for (auto i = 1; i < argc; ++i) args.add(argv[i]);
+  const auto options = parseOptions(args);
+
+  AudioPluginFormatManager formats;
+  formats.addDefaultFormats();
+
+  AudioPluginFormat* vst3 = nullptr;
+  for (auto* format : formats.getFormats()) {
+    if (format->getName() == "VST3") vst3 = format;
+  }
+  if (vst3 == nullptr) {
+    std::cout << "VST3 hosting is not enabled\n";
+    return 1;
+  }
+
+  std::cout << options.instances << " instances each, " << SampleRate
+            << " Hz, " << BlockSize << " samples\n";
+
+  auto failed = false;
+  for (const auto& path : options.paths) {
+    failed |= !benchmark(*vst3, path, options);
+  }
+  return failed ? 1 : 0;
+}
@@ -14,6 +14,7 @@ Reverb2AudioProcessorEditor::Reverb2AudioProcessorEditor(
   knobs_[ReverbParameters::Speed] = std::make_shared<Knob>("Speed");
   knobs_[ReverbParameters::Depth] = std::make_shared<Knob>("Depth");
   knobs_[ReverbParameters::Damping] = std::make_shared<Knob>("Damping");
+  knobs_[ReverbParameters::Quality] = std::make_shared<Knob>("Quality");
 
   addAndMakeVisible(titleLabel_);
   titleLabel_.setColour(Label::textColourId, Colours::lightgrey);
@@ -21,7 +22,9 @@ Reverb2AudioProcessorEditor::Reverb2AudioProcessorEditor(
   titleLabel_.setJustificationType(Justification::horizontallyCentred);
   titleLabel_.setText("R E V E R B | 2", dontSendNotification);
 
+  // Parameters without a knob are left to the host
   for (auto i = 0U; i < ReverbParameters::End; ++i) {
+    if (knobs_[i] == nullptr) continue;
     addAndMakeVisible(*knobs_[i]);
     knobs_[i]->getSlider().addListener(this);
     knobs_[i]->getSlider().setValue(processor_.getParameters()[i]->getValue());
@@ -45,7 +48,8 @@ void Reverb2AudioProcessorEditor::resized() {
   fb.flexDirection = FlexBox::Direction::row;
 
   for (auto& knob : knobs_) {
-    fb.items.add(FlexItem(getWidth() / 7, getHeight() / 5, *knob));
+    if (knob == nullptr) continue;
+    fb.items.add(FlexItem(getWidth() / 8, getHeight() / 5, *knob));
   }
 
   fb.performLayout(b);
@@ -73,5 +77,8 @@ void Reverb2AudioProcessorEditor::sliderValueChanged(Slider* slider) {
   } else if (slider == &knobs_[ReverbParameters::Damping]->getSlider()) {
     processor_.getParameters()[ReverbParameters::Damping]->setValueNotifyingHost(
         slider->getValue());
+  } else if (slider == &knobs_[ReverbParameters::Quality]->getSlider()) {
+    processor_.getParameters()[ReverbParameters::Quality]->setValueNotifyingHost(
+        slider->getValue());
   }
 }
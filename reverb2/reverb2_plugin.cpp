@@ -0,0 +1,26 @@
+#include "reverb2_processor.h"
+
+#if !HEADLESS_PLUGIN
+#include "reverb2_editor.h"
+#endif
+
+// The processor from the reverb2_dsp library with what depends on the plugin
+// target: its name and, unless built headless, its editor.
+class Reverb2Plugin : public Reverb2AudioProcessor {
+ public:
+  const juce::String getName() const override { return JucePlugin_Name; }
+
+#if !HEADLESS_PLUGIN
+  bool hasEditor() const override { return true; }
+
+  juce::AudioProcessorEditor* createEditor() override {
+    return new Reverb2AudioProcessorEditor(*this);
+  }
+#endif
+};
+
+//==============================================================================
+// This creates new instances of the plugin..
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter() {
+  return new Reverb2Plugin();
+}
@@ -1,41 +1,52 @@
 #include "reverb2_processor.h"
 
-#include "reverb2_editor.h"
-
-//==============================================================================
-Reverb2AudioProcessor::Reverb2AudioProcessor()
-    : AudioProcessor(
-          BusesProperties()
+// Main buses, then the aux inputs of the shared tank mode, off until the
+// host enables them
+static juce::AudioProcessor::BusesProperties getBusesProperties() {
+  juce::AudioProcessor::BusesProperties buses;
 #if !JucePlugin_IsMidiEffect
 #if !JucePlugin_IsSynth
-              .withInput("Input", juce::AudioChannelSet::stereo(), true)
+  buses = buses.withInput("Input", juce::AudioChannelSet::stereo(), true);
 #endif
-              .withOutput("Output", juce::AudioChannelSet::stereo(), true)
+  buses = buses.withOutput("Output", juce::AudioChannelSet::stereo(), true);
 #endif
-      ) {
-  parameters_.resize(ReverbParameters::End);
-  addParameter(parameters_[ReverbParameters::Mix] =
-                   new ReverbParam("Mix", 0.3f));
-  addParameter(parameters_[ReverbParameters::PreDelay] =
-                   new ReverbParam("Predelay", 0.01f));
-  addParameter(parameters_[ReverbParameters::Size] =
-                   new ReverbParam("Size", 0.5f));
-  addParameter(parameters_[ReverbParameters::Decay] =
-                   new ReverbParam("Decay", 0.3f));
-  addParameter(parameters_[ReverbParameters::Speed] =
-                   new ReverbParam("Speed", 0.1f));
-  addParameter(parameters_[ReverbParameters::Depth] =
-                   new ReverbParam("Depth", 0.0f));
-  addParameter(parameters_[ReverbParameters::Damping] =
-                   new ReverbParam("Damping", 0.05f));
+  for (auto i = 0; i < MaxAuxInputs; ++i) {
+    buses = buses.withInput("Aux " + String(i + 1),
+                            juce::AudioChannelSet::stereo(), false);
+  }
+  return buses;
+}
+
+//==============================================================================
+Reverb2AudioProcessor::Reverb2AudioProcessor()
+    : AudioProcessor(getBusesProperties()) {
+  parameters_.resize(NumReverbParameters);
+  for (auto i = 0U; i < ReverbParameters::End; ++i) {
+    const auto& spec = ReverbParameterSpecs[i];
+    addParameter(parameters_[i] =
+                     new ReverbParam(spec.name, spec.defaultValue,
+                                     spec.numSteps));
+  }
+  for (auto i = 0; i < MaxAuxInputs; ++i) {
+    const auto name = "Aux " + String(i + 1);
+    addParameter(parameters_[auxParameterIndex(i, AuxSend)] =
+                     new ReverbParam(name + " send", 1.0f));
+    addParameter(parameters_[auxParameterIndex(i, AuxPreDelay)] =
+                     new ReverbParam(
+                         name + " predelay",
+                         ReverbParameterSpecs[ReverbParameters::PreDelay]
+                             .defaultValue));
+  }
+  addParameter(parameters_[EarlyLevel] = new ReverbParam(
+                   EarlyLevelSpec.name, EarlyLevelSpec.defaultValue));
 }
 
 Reverb2AudioProcessor::~Reverb2AudioProcessor() {}
 
 //==============================================================================
-const juce::String Reverb2AudioProcessor::getName() const {
-  return JucePlugin_Name;
-}
+// The plugin target reports its own name and adds the editor, see
+// reverb2_plugin.cpp
+const juce::String Reverb2AudioProcessor::getName() const { return "Reverb2"; }
 
 bool Reverb2AudioProcessor::acceptsMidi() const {
 #if JucePlugin_WantsMidiInput
@@ -61,7 +72,16 @@ bool Reverb2AudioProcessor::isMidiEffect() const {
 #endif
 }
 
-double Reverb2AudioProcessor::getTailLengthSeconds() const { return 0.0; }
+// The predelay and the time the tank takes to decay by 60 dB. Before
+// prepareToPlay() the rate is not known yet and 48 kHz is assumed.
+double Reverb2AudioProcessor::getTailLengthSeconds() const {
+  const auto fs = getSampleRate() > 0.0 ? getSampleRate() : 48000.0;
+  const auto predelay =
+      20000 * parameters_[ReverbParameters::PreDelay]->getValue() / fs;
+  return predelay + reverbTank_.getDecaySeconds(
+                        parameters_[ReverbParameters::Size]->getValue(),
+                        parameters_[ReverbParameters::Decay]->getValue(), fs);
+}
 
 int Reverb2AudioProcessor::getNumPrograms() {
   return 1;  // NB: some hosts don't cope very well if you tell them there are 0
@@ -90,16 +110,92 @@ void Reverb2AudioProcessor::prepareToPlay(double sampleRate,
                                           int samplesPerBlock) {
   // Use this method as the place to do any pre-playback
   // initialisation that you need..
-  juce::ignoreUnused(samplesPerBlock);
+  // The predelay line holds a whole block on top of the longest predelay so
+  // the front stage can write a block before reading it back. The early
+  // reflections line does the same for their longest tap.
+  predelay_ = Delay(MaxPreDelay + static_cast<std::uint32_t>(samplesPerBlock));
+  predelay_.allocate();
+  earlyInput_ = Delay(EarlyReflections::getMaxDelay(sampleRate) +
+                      static_cast<std::uint32_t>(samplesPerBlock));
+  earlyInput_.allocate();
+  early_.prepare(sampleRate);
+
+  // Aux inputs the host has enabled get a predelay line of the same length
+  for (auto i = 0; i < MaxAuxInputs; ++i) {
+    auto& aux = auxInputs_[static_cast<size_t>(i)];
+    const auto* bus = getBus(true, i + 1);
+    aux.active = bus != nullptr && bus->isEnabled();
+    if (aux.active) {
+      aux.predelay = Delay(MaxPreDelay +
+                           static_cast<std::uint32_t>(samplesPerBlock));
+      aux.predelay.allocate();
+    } else {
+      aux.predelay.release();
+    }
+  }
+  auxSum_.assign(static_cast<size_t>(samplesPerBlock), 0.0f);
+  auxMono_.assign(static_cast<size_t>(samplesPerBlock), 0.0f);
+  monoRight_.assign(static_cast<size_t>(jmax(1, samplesPerBlock)), 0.0f);
+
+  for (auto& ap : inputDiffusionAps_) {
+    ap.allocate();
+  }
+  // Scratch only ever holds one sub-block
+  maxBlockSize_ = jmax(1, samplesPerBlock);
+  for (auto& scratch : scratch_) {
+    scratch.assign(
+        static_cast<size_t>(jmin(maxBlockSize_, MaxSubBlockSize)),
+        0.0f);
+  }
+
+  reverbTank_.prepare(sampleRate);
+
+  governor_.prepare(sampleRate);
+  detailStep_ = static_cast<float>(1.0 / (DetailFadeSeconds * sampleRate));
+  detail_ = qualityTierFromValue(
+                parameters_[ReverbParameters::Quality]->getValue()) ==
+                    QualityTier::Eco
+                ? 0.0f
+                : 1.0f;
+
+  bypass_.prepare(sampleRate, samplesPerBlock,
+                  parameters_[ReverbParameters::Bypass]->getValue() >= 0.5f);
 
-  reverbTank_.setSampleRate(sampleRate);
   std::cout << "Sample rate: " << sampleRate << std::endl;
   sizeCurrent_ = parameters_[ReverbParameters::Size]->getValue();
+
+  // The pipelined mode is picked up here, as it changes the latency
+  pipelined_ = parameters_[ReverbParameters::Pipeline]->getValue() >= 0.5f;
+  setLatencySamples(pipelined_ ? samplesPerBlock : 0);
+  if (pipelined_) {
+    for (auto& ring : pipelineRings_) {
+      ring.assign(2 * static_cast<size_t>(samplesPerBlock), 0.0f);
+    }
+    pipelinePos_ = 0;
+    worker_ =
+        std::make_unique<StageWorker>([this] { runPipelineFrontStage(); });
+    worker_->start();
+  } else {
+    worker_.reset();
+  }
 }
 
 void Reverb2AudioProcessor::releaseResources() {
-  // When playback stops, you can use this as an opportunity to free up any
-  // spare memory, etc.
+  predelay_.release();
+  earlyInput_.release();
+  for (auto& aux : auxInputs_) {
+    aux.predelay.release();
+    aux.active = false;
+  }
+  for (auto& ap : inputDiffusionAps_) {
+    ap.release();
+  }
+  reverbTank_.release();
+
+  worker_.reset();
+  for (auto& ring : pipelineRings_) {
+    ring = {};
+  }
 }
 
 bool Reverb2AudioProcessor::isBusesLayoutSupported(
@@ -120,111 +216,540 @@ bool Reverb2AudioProcessor::isBusesLayoutSupported(
     return false;
 #endif
 
+  // Aux inputs are mono or stereo, when enabled
+  for (auto i = 1; i < layouts.inputBuses.size(); ++i) {
+    const auto set = layouts.getChannelSet(true, i);
+    if (!set.isDisabled() && set != juce::AudioChannelSet::mono() &&
+        set != juce::AudioChannelSet::stereo())
+      return false;
+  }
+
   return true;
 #endif
 }
 
-// Plate-class reverb from J. Dattorro, Effect Design Part 1: Reverberator and Other Filters
-void Reverb2AudioProcessor::processBlock(juce::AudioBuffer<float>& buffer,
-                                         juce::MidiBuffer& midiMessages) {
-  juce::ignoreUnused(midiMessages);
+// Runs predelay, predelay filter and input diffusers stage by stage over as
+// many samples as one pass allows, leaving the diffused signal in
+// scratch_[ScratchB]. Returns the number of samples processed. The pass is
+// limited by the scratch size; diffusers shorter than the pass run it in
+// parts of their own delay. At detail 0 only the eco diffusers run; in
+// between, both chain lengths are blended.
+// aux, if not null, is the already predelayed sum of the aux inputs. With
+// early, the early reflections of the main and aux inputs are left in
+// scratch_[EarlyLeft] and scratch_[EarlyRight].
+int Reverb2AudioProcessor::processFrontStage(const float* left,
+                                             const float* right,
+                                             const float* aux, int numSamples,
+                                             std::uint32_t predelay,
+                                             float size, float detail,
+                                             bool early) {
+  const auto numDiffusers =
+      detail > 0.0f ? inputDiffusionAps_.size() : EcoDiffusers;
+
+  std::array<std::uint32_t, 4> delays{};
+  auto maxSamples = static_cast<std::uint32_t>(scratch_[0].size());
+  maxSamples = std::min(maxSamples, predelay_.size() + 1 - predelay);
+  if (early) {
+    early_.setSize(size);
+    maxSamples =
+        std::min(maxSamples, earlyInput_.capacity() - early_.getReach());
+  }
+  for (auto i = 0U; i < numDiffusers; ++i) {
+    const auto delay = std::ceil(size * inputDiffusionAps_[i].size() - 1);
+    delays[i] = static_cast<std::uint32_t>(std::max(1.0f, delay));
+  }
+  const auto n = std::min(numSamples, static_cast<int>(maxSamples));
+
+  auto* a = scratch_[ScratchA].data();
+  auto* b = scratch_[ScratchB].data();
+  auto* eco = scratch_[ScratchEco].data();
+
+  // Predelay + low pass filter
+  FloatVectorOperations::add(a, left, right, n);
+  FloatVectorOperations::multiply(a, 0.5f, n);
+  predelay_.writeBlock(a, n);
+  predelay_.readBlock(b, n, predelay + n - 1);
+  if (aux != nullptr) FloatVectorOperations::add(b, aux, n);
+
+  // The reflections tap everything that enters the tank, each input after
+  // its own predelay. The line is kept up to date while they are off, so
+  // that they come back in on the right history.
+  earlyInput_.writeBlock(b, n);
+  if (early) {
+    early_.process(earlyInput_, n, scratch_[EarlyLeft].data(),
+                   scratch_[EarlyRight].data(), n, kernels_);
+  }
+  for (auto i = 0; i < n; ++i) {
+    b[i] = predelayFilter_.process(b[i], 0.9995, 1 - 0.9995);
+  }
 
-  juce::ScopedNoDenormals noDenormals;
+  // Input Diffusers, ping-ponging between the scratch buffers. An even
+  // number of stages leaves the result in scratch_[ScratchB].
+  for (auto i = 0U; i < numDiffusers; ++i) {
+    if (i == EcoDiffusers && detail < 1.0f) {
+      FloatVectorOperations::copy(eco, b, n);
+    }
+    inputDiffusionAps_[i].processBlock(b, a, n, delays[i], kernels_);
+    std::swap(a, b);
+  }
 
-  auto num_samples = buffer.getNumSamples();
-  auto inL = buffer.getReadPointer(0);
-  auto inR = buffer.getReadPointer(1);
-  auto outL = buffer.getWritePointer(0);
-  auto outR = buffer.getWritePointer(1);
+  if (numDiffusers > EcoDiffusers && detail < 1.0f) {
+    FloatVectorOperations::multiply(b, detail, n);
+    FloatVectorOperations::addWithMultiply(b, eco, 1.0f - detail, n);
+  }
 
-  auto mix = parameters_[ReverbParameters::Mix]->getValue();
-  auto predelay = 20000 * parameters_[ReverbParameters::PreDelay]->getValue();
-  auto damping = parameters_[ReverbParameters::Damping]->getValue();
-  auto decay = parameters_[ReverbParameters::Decay]->getValue();
-  auto speed = parameters_[ReverbParameters::Speed]->getValue();
-  auto depth = parameters_[ReverbParameters::Depth]->getValue();
-  auto size = parameters_[ReverbParameters::Size]->getValue();
-
-  while (num_samples--) {
-    if (sizeCurrent_ < size) {
+  return n;
+}
+
+// Steps the tier crossfade by numSamples towards target
+void Reverb2AudioProcessor::stepDetail(int numSamples, float target) {
+  if (detail_ < target) {
+    detail_ = jmin(target, detail_ + numSamples * detailStep_);
+  } else if (detail_ > target) {
+    detail_ = jmax(target, detail_ - numSamples * detailStep_);
+    if (detail_ == 0.0f) {
+      // Diffusers that stop running are faded back in from silence
+      for (auto i = EcoDiffusers; i < inputDiffusionAps_.size(); ++i) {
+        inputDiffusionAps_[i].clear();
+      }
+    }
+  }
+}
+
+// Runs the tank on the front stage output and mixes it with the dry input.
+// detail holds the tier crossfade each diffused sample was made with.
+// earlyL and earlyR, if not null, are the early reflections to add to the
+// tank output.
+void Reverb2AudioProcessor::processTank(const float* diffused,
+                                        const float* detail,
+                                        const float* earlyL,
+                                        const float* earlyR,
+                                        const float* left, const float* right,
+                                        float* outL, float* outR,
+                                        int numSamples,
+                                        const TankSettings& settings) {
+  const auto mix = settings.mix;
+  for (auto i = 0; i < numSamples; ++i) {
+    if (sizeCurrent_ < settings.size) {
       sizeCurrent_ += 0.000005f;
-    } else if (sizeCurrent_ > size) {
+    } else if (sizeCurrent_ > settings.size) {
       sizeCurrent_ -= 0.000005f;
     }
 
-    const auto left = *inL++;
-    const auto right = *inR++;
+    const auto dryL = left[i];
+    const auto dryR = right[i];
+
+    // Tank
+    const auto wet = reverbTank_.process(
+        diffused[i], sizeCurrent_, settings.decay, settings.damping,
+        settings.speed, settings.depth, detail[i], settings.interpolate);
+
+    auto wetL = std::get<0>(wet);
+    auto wetR = std::get<1>(wet);
+    if (earlyL != nullptr) {
+      wetL += settings.early * earlyL[i];
+      wetR += settings.early * earlyR[i];
+    }
+
+    outL[i] = wetL * mix + dryL * (1 - mix);
+    outR[i] = wetR * mix + dryR * (1 - mix);
+  }
+}
+
+// Calls fn(ringPos, offset, n) for the one or two contiguous runs that
+// numSamples samples starting at ringPos take up in a ring of ringSize.
+template <typename Fn>
+static void forEachRingRun(int ringPos, int numSamples, int ringSize, Fn fn) {
+  const auto first = jmin(numSamples, ringSize - ringPos);
+  fn(ringPos, 0, first);
+  if (first < numSamples) fn(0, first, numSamples - first);
+}
+
+// Worker side of the pipeline: predelay, filter and input diffusers for the
+// block in frontJob_, from the dry rings into the diffused rings.
+void Reverb2AudioProcessor::runPipelineFrontStage() {
+  const auto job = frontJob_;
+  const auto ringSize = static_cast<int>(pipelineRings_[DryLeft].size());
+
+  forEachRingRun(job.start, job.numSamples, ringSize,
+                 [&](int pos, int, int numSamples) {
+                   while (numSamples > 0) {
+                     const auto n = processFrontStage(
+                         pipelineRings_[DryLeft].data() + pos,
+                         pipelineRings_[DryRight].data() + pos,
+                         job.hasAux ? pipelineRings_[AuxSum].data() + pos
+                                    : nullptr,
+                         numSamples, job.predelay, job.size, detail_,
+                         job.hasEarly);
+                     FloatVectorOperations::copy(
+                         pipelineRings_[Diffused].data() + pos,
+                         scratch_[ScratchB].data(), n);
+                     if (job.hasEarly) {
+                       FloatVectorOperations::copy(
+                           pipelineRings_[EarlyLeftRing].data() + pos,
+                           scratch_[EarlyLeft].data(), n);
+                       FloatVectorOperations::copy(
+                           pipelineRings_[EarlyRightRing].data() + pos,
+                           scratch_[EarlyRight].data(), n);
+                     }
+                     FloatVectorOperations::fill(
+                         pipelineRings_[DiffusedDetail].data() + pos, detail_,
+                         n);
+                     stepDetail(n, job.detailTarget);
+                     pos += n;
+                     numSamples -= n;
+                   }
+                 });
+}
+
+// Audio thread side of the pipeline: hands this block to the front stage on
+// the worker, and meanwhile runs the tank on the front stage output from one
+// block of latency ago. The two regions of the rings never overlap, as a
+// block is at most half a ring.
+void Reverb2AudioProcessor::processPipelined(const float* inL,
+                                             const float* inR,
+                                             const float* aux, float* outL,
+                                             float* outR, int numSamples,
+                                             const FrontJob& job,
+                                             const TankSettings& settings) {
+  const auto ringSize = static_cast<int>(pipelineRings_[DryLeft].size());
+  const auto writePos = pipelinePos_;
+  const auto readPos = (writePos + ringSize / 2) % ringSize;
+  // The tank reads what the previous job left in the rings
+  const auto hasEarly = frontJob_.hasEarly && settings.early > 0.0f;
+
+  forEachRingRun(writePos, numSamples, ringSize,
+                 [&](int pos, int offset, int n) {
+                   FloatVectorOperations::copy(
+                       pipelineRings_[DryLeft].data() + pos, inL + offset, n);
+                   FloatVectorOperations::copy(
+                       pipelineRings_[DryRight].data() + pos, inR + offset, n);
+                   if (aux != nullptr) {
+                     FloatVectorOperations::copy(
+                         pipelineRings_[AuxSum].data() + pos, aux + offset, n);
+                   }
+                 });
+
+  frontJob_ = job;
+  frontJob_.start = writePos;
+  frontJob_.numSamples = numSamples;
+  worker_->kick();
+
+  forEachRingRun(readPos, numSamples, ringSize,
+                 [&](int pos, int offset, int n) {
+                   processTank(
+                       pipelineRings_[Diffused].data() + pos,
+                       pipelineRings_[DiffusedDetail].data() + pos,
+                       hasEarly ? pipelineRings_[EarlyLeftRing].data() + pos
+                                : nullptr,
+                       hasEarly ? pipelineRings_[EarlyRightRing].data() + pos
+                                : nullptr,
+                       pipelineRings_[DryLeft].data() + pos,
+                       pipelineRings_[DryRight].data() + pos, outL + offset,
+                       outR + offset, n, settings);
+                 });
+
+  worker_->wait();
+  pipelinePos_ = (writePos + numSamples) % ringSize;
+}
+
+// The dry input as the output carries it: one block late when pipelined,
+// through the dry rings the pipeline keeps anyway
+void Reverb2AudioProcessor::readDry(const float* inL, const float* inR,
+                                    float* outL, float* outR,
+                                    int numSamples) {
+  if (!pipelined_) {
+    if (outL != inL) FloatVectorOperations::copy(outL, inL, numSamples);
+    if (outR != inR) FloatVectorOperations::copy(outR, inR, numSamples);
+    return;
+  }
+
+  const auto ringSize = static_cast<int>(pipelineRings_[DryLeft].size());
+  forEachRingRun(pipelinePos_, numSamples, ringSize,
+                 [&](int pos, int offset, int n) {
+                   FloatVectorOperations::copy(
+                       pipelineRings_[DryLeft].data() + pos, inL + offset, n);
+                   FloatVectorOperations::copy(
+                       pipelineRings_[DryRight].data() + pos, inR + offset, n);
+                 });
+  forEachRingRun((pipelinePos_ + ringSize / 2) % ringSize, numSamples,
+                 ringSize, [&](int pos, int offset, int n) {
+                   FloatVectorOperations::copy(
+                       outL + offset, pipelineRings_[DryLeft].data() + pos, n);
+                   FloatVectorOperations::copy(
+                       outR + offset, pipelineRings_[DryRight].data() + pos, n);
+                 });
+}
+
+// Silences everything that rings, leaving the dry rings to carry the latency
+void Reverb2AudioProcessor::clearMemory() {
+  predelay_.clear();
+  earlyInput_.clear();
+  for (auto& aux : auxInputs_) {
+    if (aux.active) aux.predelay.clear();
+  }
+  predelayFilter_.clear();
+  for (auto& ap : inputDiffusionAps_) {
+    ap.clear();
+  }
+  reverbTank_.clear();
+
+  if (pipelined_) {
+    for (auto ring :
+         {Diffused, DiffusedDetail, EarlyLeftRing, EarlyRightRing}) {
+      auto& samples = pipelineRings_[ring];
+      FloatVectorOperations::clear(samples.data(),
+                                   static_cast<int>(samples.size()));
+    }
+  }
+}
+
+// Shared tank mode: predelays each aux input and sums it into auxSum_ at
+// its send gain, mono like the main input. Returns null without aux inputs.
+const float* Reverb2AudioProcessor::sumAuxInputs(int numSamples) {
+  auto* sum = auxSum_.data();
+  auto* mono = auxMono_.data();
+  auto any = false;
+
+  for (auto i = 0; i < MaxAuxInputs; ++i) {
+    auto& aux = auxInputs_[static_cast<size_t>(i)];
+    if (aux.left == nullptr) continue;
+
+    const auto send =
+        0.5f * parameters_[auxParameterIndex(i, AuxSend)]->getValue();
+    const auto predelay = static_cast<std::uint32_t>(std::max(
+        1.0f, std::ceil(MaxPreDelay *
+                        parameters_[auxParameterIndex(i, AuxPreDelay)]
+                            ->getValue())));
+
+    FloatVectorOperations::add(mono, aux.left, aux.right, numSamples);
+    aux.predelay.writeBlock(mono, numSamples);
+    aux.predelay.readBlock(mono, numSamples, predelay + numSamples - 1);
+    if (any) {
+      FloatVectorOperations::addWithMultiply(sum, mono, send, numSamples);
+    } else {
+      FloatVectorOperations::copyWithMultiply(sum, mono, send, numSamples);
+    }
+    any = true;
+  }
+
+  return any ? sum : nullptr;
+}
+
+void Reverb2AudioProcessor::processBlock(juce::AudioBuffer<float>& buffer,
+                                         juce::MidiBuffer& midiMessages) {
+  juce::ignoreUnused(midiMessages);
 
-    const auto in = 0.5 * (left + right);
+  // Point the enabled aux inputs at their channels for this block
+  for (auto i = 0; i < MaxAuxInputs; ++i) {
+    auto& aux = auxInputs_[static_cast<size_t>(i)];
+    const auto* bus = getBus(true, i + 1);
+    if (!aux.active || bus == nullptr || !bus->isEnabled()) continue;
 
-    // Predelay + low pass filter
-    predelay_.write(in);
-    auto predelayed = predelay_.read(predelay);
-    predelayed = predelayFilter_.process(predelayed, 0.9995, 1 - 0.9995);
+    const auto first = bus->getChannelIndexInProcessBlockBuffer(0);
+    const auto last = first + jmin(1, bus->getNumberOfChannels() - 1);
+    aux.left = buffer.getReadPointer(first);
+    aux.right = buffer.getReadPointer(last);
+  }
 
-    // Input Diffusers
-    auto diffused = predelayed;
-    for (auto& ap : inputDiffusionAps_) {
-      diffused = ap.process(diffused, sizeCurrent_ * ap.size() - 1);
+  processMainBus(buffer, [this](const float* inL, const float* inR,
+                                float* outL, float* outR, int numSamples) {
+    process(inL, inR, outL, outR, numSamples);
+  });
+
+  for (auto& aux : auxInputs_) {
+    aux.left = aux.right = nullptr;
+  }
+}
+
+void Reverb2AudioProcessor::processBlockBypassed(
+    juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) {
+  juce::ignoreUnused(midiMessages);
+
+  processMainBus(buffer, [this](const float* inL, const float* inR,
+                                float* outL, float* outR, int numSamples) {
+    forEachSubBlock(numSamples, maxBlockSize_, [&](int offset, int n) {
+      processWithBypass(inL + offset, inR + offset, outL + offset,
+                        outR + offset, n, true);
+    });
+  });
+}
+
+// Runs fn(inL, inR, outL, outR, numSamples) on the main bus, whose channels
+// need not be the first two of buffer when it is mono. A mono bus feeds
+// both sides and gets the two outputs folded back into one.
+template <typename Fn>
+void Reverb2AudioProcessor::processMainBus(juce::AudioBuffer<float>& buffer,
+                                           Fn&& fn) {
+  auto main = getBusBuffer(buffer, true, 0);
+  auto* left = main.getWritePointer(0);
+  if (main.getNumChannels() > 1) {
+    auto* right = main.getWritePointer(1);
+    fn(left, right, left, right, main.getNumSamples());
+    return;
+  }
+
+  auto* right = monoRight_.data();
+  forEachSubBlock(main.getNumSamples(), maxBlockSize_, [&](int offset, int n) {
+    FloatVectorOperations::copy(right, left + offset, n);
+    fn(left + offset, right, left + offset, right, n);
+    FloatVectorOperations::add(left + offset, right, n);
+    FloatVectorOperations::multiply(left + offset, 0.5f, n);
+  });
+}
+
+void Reverb2AudioProcessor::process(const float* inL, const float* inR,
+                                    float* outL, float* outR, int numSamples) {
+  const auto bypass =
+      parameters_[ReverbParameters::Bypass]->getValue() >= 0.5f;
+  forEachSubBlock(numSamples, maxBlockSize_, [&](int offset, int n) {
+    processWithBypass(inL + offset, inR + offset, outL + offset,
+                      outR + offset, n, bypass);
+    for (auto& aux : auxInputs_) {
+      if (aux.left == nullptr) continue;
+      aux.left += n;
+      aux.right += n;
     }
+  });
+}
 
-    // Tank
-    const auto wet = reverbTank_.process(diffused, sizeCurrent_, decay, damping,
-                                         speed, depth);
+// Fully bypassed, only the dry signal is passed on and nothing else runs
+void Reverb2AudioProcessor::processWithBypass(const float* inL,
+                                              const float* inR, float* outL,
+                                              float* outR, int numSamples,
+                                              bool bypass) {
+  juce::ScopedNoDenormals noDenormals;
 
-    *outL++ = std::get<0>(wet) * mix + left * (1 - mix);
-    *outR++ = std::get<1>(wet) * mix + right * (1 - mix);
+  switch (bypass_.getStage(bypass)) {
+    case BypassFade::Stage::Active:
+      processActive(inL, inR, outL, outR, numSamples);
+      break;
+
+    case BypassFade::Stage::Fading:
+      if (bypass_.leaveBypassed()) {
+        sizeCurrent_ = parameters_[ReverbParameters::Size]->getValue();
+      }
+      readDry(inL, inR, bypass_.getDry(0), bypass_.getDry(1), numSamples);
+      processActive(inL, inR, outL, outR, numSamples);
+      bypass_.fade(outL, outR, numSamples, bypass);
+      break;
+
+    case BypassFade::Stage::Bypassed:
+      if (bypass_.enterBypassed()) clearMemory();
+      readDry(inL, inR, outL, outR, numSamples);
+      if (pipelined_) {
+        pipelinePos_ = (pipelinePos_ + numSamples) %
+                       static_cast<int>(pipelineRings_[DryLeft].size());
+      }
+      break;
   }
 }
 
-//==============================================================================
-bool Reverb2AudioProcessor::hasEditor() const {
-  return true;  // (change this to false if you choose to not supply an editor)
+// Plate-class reverb from J. Dattorro, Effect Design Part 1: Reverberator and Other Filters
+void Reverb2AudioProcessor::processActive(const float* inL, const float* inR,
+                                          float* outL, float* outR,
+                                          int numSamples) {
+  auto predelay = 20000 * parameters_[ReverbParameters::PreDelay]->getValue();
+
+  const auto predelaySamples =
+      static_cast<std::uint32_t>(std::max(1.0f, std::ceil(predelay)));
+
+  const auto adaptive =
+      parameters_[ReverbParameters::Adaptive]->getValue() >= 0.5f;
+  // The clock is only read for the governor
+  const auto startTicks = adaptive ? Time::getHighResolutionTicks() : 0;
+  const auto tier = governor_.getTier(
+      qualityTierFromValue(parameters_[ReverbParameters::Quality]->getValue()),
+      adaptive);
+  const auto detailTarget = tier == QualityTier::Eco ? 0.0f : 1.0f;
+
+  TankSettings settings{};
+  settings.mix = parameters_[ReverbParameters::Mix]->getValue();
+  settings.size = parameters_[ReverbParameters::Size]->getValue();
+  settings.decay = parameters_[ReverbParameters::Decay]->getValue();
+  settings.damping = parameters_[ReverbParameters::Damping]->getValue();
+  settings.speed = parameters_[ReverbParameters::Speed]->getValue();
+  settings.depth = parameters_[ReverbParameters::Depth]->getValue();
+  settings.early = parameters_[EarlyLevel]->getValue();
+  settings.interpolate = tier == QualityTier::High;
+
+  const auto* aux = sumAuxInputs(numSamples);
+
+  if (pipelined_) {
+    const FrontJob job{0, 0, predelaySamples, sizeCurrent_, detailTarget,
+                       aux != nullptr, settings.early > 0.0f};
+    processPipelined(inL, inR, aux, outL, outR, numSamples, job, settings);
+  } else {
+    const auto early = settings.early > 0.0f;
+    auto remaining = numSamples;
+    while (remaining > 0) {
+      const auto n =
+          processFrontStage(inL, inR, aux, remaining, predelaySamples,
+                            sizeCurrent_, detail_, early);
+      remaining -= n;
+
+      // The whole pass was diffused with the same detail
+      auto* detail = scratch_[ScratchA].data();
+      FloatVectorOperations::fill(detail, detail_, n);
+      stepDetail(n, detailTarget);
+
+      processTank(scratch_[ScratchB].data(), detail,
+                  early ? scratch_[EarlyLeft].data() : nullptr,
+                  early ? scratch_[EarlyRight].data() : nullptr, inL, inR,
+                  outL, outR, n, settings);
+      inL += n;
+      inR += n;
+      if (aux != nullptr) aux += n;
+      outL += n;
+      outR += n;
+    }
+  }
+
+  if (adaptive) governor_.update(startTicks, numSamples);
+}
+
+AudioProcessorParameter* Reverb2AudioProcessor::getBypassParameter() const {
+  return parameters_[ReverbParameters::Bypass];
 }
 
+//==============================================================================
+bool Reverb2AudioProcessor::hasEditor() const { return false; }
+
 juce::AudioProcessorEditor* Reverb2AudioProcessor::createEditor() {
-  return new Reverb2AudioProcessorEditor(*this);
+  return nullptr;
 }
 
 //==============================================================================
 void Reverb2AudioProcessor::getStateInformation(juce::MemoryBlock& destData) {
-  // You should use this method to store your parameters in the memory block.
-  // You could do that either as raw data, or use the XML or ValueTree classes
-  // as intermediaries to make it easy to save and load complex data.
-  std::unique_ptr<juce::XmlElement> xml (new juce::XmlElement("Reverb2"));
-  xml->setAttribute("Mix", parameters_[Mix]->getValue());
-  xml->setAttribute("PreDelay", parameters_[PreDelay]->getValue());
-  xml->setAttribute("Size", parameters_[Size]->getValue());
-  xml->setAttribute("Decay", parameters_[Decay]->getValue());
-  xml->setAttribute("Speed", parameters_[Speed]->getValue());
-  xml->setAttribute("Depth", parameters_[Depth]->getValue());
-  xml->setAttribute("Damping", parameters_[Damping]->getValue());
-  copyXmlToBinary(*xml, destData);
+  BinaryState::write(destData, StateTag, parameters_);
 }
 
 void Reverb2AudioProcessor::setStateInformation(const void* data,
                                                 int sizeInBytes) {
+  if (BinaryState::read(data, sizeInBytes, StateTag, parameters_) !=
+      BinaryState::ReadResult::NotBinary)
+    return;
+
+  // States saved before the binary format are XML
   std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
 
   if (xmlState.get() != nullptr)
     if (xmlState->hasTagName("Reverb2"))
     {
-      parameters_[Mix]->setValue(xmlState->getDoubleAttribute("Mix", 0.3));
-      parameters_[PreDelay]->setValue(xmlState->getDoubleAttribute("PreDelay", 0.01));
-      parameters_[Size]->setValue(xmlState->getDoubleAttribute("Size", 0.5));
-      parameters_[Decay]->setValue(xmlState->getDoubleAttribute("Decay", 0.3));
-      parameters_[Speed]->setValue(xmlState->getDoubleAttribute("Speed", 0.1));
-      parameters_[Depth]->setValue(xmlState->getDoubleAttribute("Depth", 0.0));
-      parameters_[Damping]->setValue(xmlState->getDoubleAttribute("Damping", 0.05));
+      // Only the main parameters were saved; the aux and early ones go back
+      // to their defaults as they do for an older binary state
+      for (auto i = 0U; i < parameters_.size(); ++i) {
+        if (i < ReverbParameters::End) {
+          const auto& spec = ReverbParameterSpecs[i];
+          parameters_[i]->setValue(
+              xmlState->getDoubleAttribute(spec.key, spec.defaultValue));
+        } else {
+          parameters_[i]->setValue(parameters_[i]->getDefaultValue());
+        }
+      }
     }
 }
 
 std::vector<AudioProcessorParameter*> Reverb2AudioProcessor::getParameters() {
   return parameters_;
 }
-
-//==============================================================================
-// This creates new instances of the plugin..
-juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter() {
-  return new Reverb2AudioProcessor();
-}
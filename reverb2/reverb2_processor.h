@@ -2,9 +2,19 @@
 
 #include <juce_audio_processors/juce_audio_processors.h>
 
+#include "binary_state.h"
+#include "bypass_fade.h"
+#include "delay_line.h"
+#include "dsp_kernels.h"
+#include "frame_delay.h"
+#include "quality_governor.h"
+#include "sub_block.h"
+#include "stage_worker.h"
+
 using namespace juce;
 
-enum ReverbParameters {
+namespace ReverbParameters {
+enum Parameter {
   Mix,
   PreDelay,
   Size,
@@ -12,40 +22,133 @@ enum ReverbParameters {
   Speed,
   Depth,
   Damping,
+  Quality,
+  Adaptive,
+  Pipeline,
+  Bypass,
   End
 };
+}  // namespace ReverbParameters
+
+constexpr ParameterSpec ReverbParameterSpecs[ReverbParameters::End] = {
+    {"Mix", "Mix", 0.3f},
+    {"PreDelay", "Predelay", 0.01f},
+    {"Size", "Size", 0.5f},
+    {"Decay", "Decay", 0.3f},
+    {"Speed", "Speed", 0.1f},
+    {"Depth", "Depth", 0.0f},
+    {"Damping", "Damping", 0.05f},
+    {"Quality", "Quality", 0.5f, 3},
+    {"Adaptive", "Adaptive quality", 0.0f, 2},
+    {"Pipeline", "Pipelined processing", 0.0f, 2},
+    {"Bypass", "Bypass", 0.0f, 2}};
+
+// Aux inputs of the shared tank mode: up to MaxAuxInputs extra input buses
+// feed the one tank, each with a send and a predelay parameter, the predelay
+// starting out as the main one does. These come
+// after the ReverbParameters, NumAuxParameters per input.
+constexpr int MaxAuxInputs = 16;
+enum AuxParameters { AuxSend, AuxPreDelay, NumAuxParameters };
+
+constexpr int auxParameterIndex(int input, AuxParameters parameter) {
+  return ReverbParameters::End + input * NumAuxParameters + parameter;
+}
+
+// Early reflections level, after the aux parameters so that states saved
+// before it load with the reflections off
+constexpr int EarlyLevel = auxParameterIndex(MaxAuxInputs, AuxSend);
+constexpr ParameterSpec EarlyLevelSpec{"Early", "Early reflections", 0.0f};
+
+// All parameters, the aux ones included
+constexpr int NumReverbParameters = EarlyLevel + 1;
 
 class Allpass {
  public:
   Allpass(std::uint32_t size, float fbGain, float ffGain)
-      : size_(size), fbGain_(fbGain), ffGain_(ffGain) {
-    buffer_.resize(size);
-    std::fill(buffer_.begin(), buffer_.end(), 0);
+      : size_(size), fbGain_(fbGain), ffGain_(ffGain) {}
+
+  // Takes memory from the DelayMemoryPool; see Delay::allocate()
+  inline void allocate(std::uint32_t minCapacity = 0) {
+    buffer_ = DelayMemoryPool::getInstance().acquire(jmax(size_, minCapacity));
+    capacity_ = buffer_.size();
+    index_ = 0;
+  }
+
+  inline void release() {
+    buffer_.reset();
+    capacity_ = 0;
+    index_ = 0;
   }
 
   inline float process(float in, float delay) {
     auto m = index_ - delay;
-    if (m < 0) m += size_;
+    if (m < 0) m += capacity_;
 
     const auto y = buffer_[m] + ffGain_ * in;
-    buffer_[index_++] = in + fbGain_ * y;
-    if (index_ >= size_) index_ = 0;
+    buffer_.write(index_++, in + fbGain_ * y);
+    if (index_ >= capacity_) index_ = 0;
+
+    return y;
+  }
+
+  // process() with a linearly interpolated read, for modulated delays
+  inline float processInterpolated(float in, float delay) {
+    auto m = index_ - delay;
+    if (m < 0) m += capacity_;
+
+    // The mirrored buffer makes buffer_[capacity_] the same as buffer_[0]
+    const auto i = static_cast<std::uint32_t>(m);
+    const auto frac = m - i;
+    const auto delayed = buffer_[i] + frac * (buffer_[i + 1] - buffer_[i]);
+
+    const auto y = delayed + ffGain_ * in;
+    buffer_.write(index_++, in + fbGain_ * y);
+    if (index_ >= capacity_) index_ = 0;
 
     return y;
   }
 
+  inline void clear() {
+    buffer_.clear();
+    index_ = 0;
+  }
+
+  // Block version of process() with one integer delay for the whole run,
+  // for 1 <= delay. Each kernel call covers at most delay samples, so every
+  // read hits a sample written before the call and the read/write regions
+  // never overlap; longer runs are split into delay-long parts.
+  inline void processBlock(const float* in, float* out, int numSamples,
+                           std::uint32_t delay, const DspKernels& kernels) {
+    while (numSamples > 0) {
+      const auto n = jmin(numSamples, static_cast<int>(delay));
+      const auto readIndex =
+          index_ >= delay ? index_ - delay : index_ + capacity_ - delay;
+
+      kernels.allpass(in, buffer_.data() + readIndex, out,
+                      buffer_.data() + index_, ffGain_, fbGain_, n);
+
+      buffer_.commit(index_, static_cast<std::uint32_t>(n));
+      index_ += static_cast<std::uint32_t>(n);
+      if (index_ >= capacity_) index_ -= capacity_;
+      in += n;
+      out += n;
+      numSamples -= n;
+    }
+  }
+
   inline float tap(std::uint32_t index) const {
     std::int32_t m = index_ - index;
-    if (m < 0) m += size_;
+    if (m < 0) m += capacity_;
     return buffer_[m];
   }
 
   inline std::uint32_t size() const { return size_; }
 
  private:
-  std::vector<float> buffer_{};
+  DelayMemoryPool::Block buffer_{};
   std::uint32_t index_{};
   std::uint32_t size_{};
+  std::uint32_t capacity_{};
   float fbGain_{};
   float ffGain_{};
 };
@@ -56,46 +159,163 @@ class LPFilter {
     return x1_ = gain * input + fbGain * x1_;
   }
 
+  inline void clear() { x1_ = 0.0f; }
+
  private:
   float x1_{};
 };
 
-class Delay {
+// Early reflections as a fixed pattern of sparse taps on a delay line, each
+// with a delay, a gain and a pan. The taps get denser and quieter with time,
+// like reflections off more and more distant walls. Delays scale with size;
+// the table is only rebuilt when size changes.
+class EarlyReflections {
  public:
-  Delay(std::uint32_t size) : size_(size) {
-    buffer_.resize(size);
-    std::fill(buffer_.begin(), buffer_.end(), 0);
+  static constexpr int NumTaps = 64;
+
+  EarlyReflections() {
+    // The same pseudo-random pattern in every instance
+    std::uint32_t seed = 0x5eed;
+    const auto next = [&seed] {
+      seed = seed * 1664525u + 1013904223u;
+      return static_cast<float>(seed >> 8) / 16777216.0f;
+    };
+
+    auto energy = 0.0f;
+    for (auto t = 0; t < NumTaps; ++t) {
+      const auto position = (t + next()) / NumTaps;
+      seconds_[t] = MaxSeconds * (0.05f + 0.95f * std::sqrt(position));
+
+      const auto gain = (next() < 0.5f ? -1.0f : 1.0f) *
+                        std::exp(-2.5f * position);
+      const auto side = t % 2 == 0 ? -1.0f : 1.0f;
+      const auto pan = 0.5f + side * (0.15f + 0.35f * next());
+      gainsL_[t] = gain * std::cos(pan * MathConstants<float>::halfPi);
+      gainsR_[t] = gain * std::sin(pan * MathConstants<float>::halfPi);
+      energy += gain * gain;
+    }
+
+    // About as loud as the input, whatever the pattern
+    const auto norm = 1.0f / std::sqrt(energy);
+    for (auto t = 0; t < NumTaps; ++t) {
+      gainsL_[t] *= norm;
+      gainsR_[t] *= norm;
+    }
   }
 
-  inline float read(float delay) const {
-    auto m = index_ - delay;
-    if (m < 0) m += size_;
+  // How far back the taps reach at size 1, for sizing the line they read
+  static std::uint32_t getMaxDelay(double sampleRate) {
+    return static_cast<std::uint32_t>(std::ceil(MaxSeconds * sampleRate)) + 1;
+  }
 
-    return buffer_[m];
+  inline void prepare(double sampleRate) {
+    fs_ = static_cast<float>(sampleRate);
+    size_ = -1.0f;
   }
 
-  inline void write(float in) {
-    buffer_[index_++] = in;
-    if (index_ >= size_) index_ = 0;
+  inline void setSize(float size) {
+    if (size == size_) return;
+    size_ = size;
+    for (auto t = 0; t < NumTaps; ++t) {
+      offsets_[t] = static_cast<std::uint32_t>(size * seconds_[t] * fs_);
+    }
   }
 
-  inline std::uint32_t size() const { return size_; }
+  // Longest tap delay at the current size
+  inline std::uint32_t getReach() const { return offsets_.back(); }
+
+  // Sums the taps over the next numSamples samples of line into outL and
+  // outR, each tap reading that much further back than
+  // line.readBlock(..., delay) would.
+  inline void process(const Delay& line, std::uint32_t delay, float* outL,
+                      float* outR, int numSamples,
+                      const DspKernels& kernels) const {
+    std::array<const float*, NumTaps> taps;
+    for (auto t = 0; t < NumTaps; ++t) {
+      taps[t] = line.readPointer(delay + offsets_[t]);
+    }
+    kernels.sparseTaps(taps.data(), gainsL_.data(), gainsR_.data(), NumTaps,
+                       outL, outR, numSamples);
+  }
 
  private:
-  std::vector<float> buffer_;
-  std::uint32_t size_{};
-  std::uint32_t index_{};
+  // Latest tap at size 1
+  static constexpr float MaxSeconds = 0.08f;
+
+  std::array<float, NumTaps> seconds_{};
+  std::array<float, NumTaps> gainsL_{};
+  std::array<float, NumTaps> gainsR_{};
+  std::array<std::uint32_t, NumTaps> offsets_{};
+  float fs_{};
+  float size_{-1.0f};
 };
 
 class ReverbTank {
  public:
   ReverbTank() {}
 
-  inline void setSampleRate(float fs) { fs_ = fs; }
+  // Sets the sample rate and takes the tank memory from the pool. The output
+  // taps are scaled by the sample rate, so lines they read from are made
+  // long enough for the longest tap at this rate.
+  inline void prepare(float fs) {
+    fs_ = fs;
+    const float ratio = fs_ / 29761.0f;
+    const auto tapSpan = [ratio](float longestTap) {
+      return static_cast<std::uint32_t>(std::ceil(2 * longestTap * ratio)) + 1;
+    };
+
+    decayDiffusion1Left_.allocate();
+    decayDiffusion2Left_.allocate(tapSpan(1228.0f));
+    decayDiffusion1Right_.allocate();
+    decayDiffusion2Right_.allocate(tapSpan(1913.0f));
+
+    delay1_.allocate(tapSpan(3627.0f));
+    delay2_.allocate(tapSpan(2673.0f));
+  }
+
+  inline void release() {
+    decayDiffusion1Left_.release();
+    decayDiffusion2Left_.release();
+    decayDiffusion1Right_.release();
+    decayDiffusion2Right_.release();
+
+    delay1_.release();
+    delay2_.release();
+  }
+
+  // Seconds for the tank to decay by 60 dB at rate fs. A trip round both
+  // halves passes through decay four times.
+  inline double getDecaySeconds(float size, float decay, double fs) const {
+    if (decay >= 1.0f) return std::numeric_limits<double>::infinity();
+    if (decay <= 0.0f) return 0.0;
+
+    const auto loop =
+        Diffusion1BaseDelayLeft + delay1_.size(Left) +
+        decayDiffusion2Left_.size() + delay2_.size(Left) +
+        Diffusion1BaseDelayRight + delay1_.size(Right) +
+        decayDiffusion2Right_.size() + delay2_.size(Right);
+    return size * loop / fs * std::log(0.001) / (4.0 * std::log(decay));
+  }
+
+  inline void clear() {
+    decayDiffusion1Left_.clear();
+    decayDiffusion2Left_.clear();
+    dampingLeft_.clear();
+    decayDiffusion1Right_.clear();
+    decayDiffusion2Right_.clear();
+    dampingRight_.clear();
+
+    delay1_.clear();
+    delay2_.clear();
+    modPhase_ = 0.0f;
+  }
 
+  // extraTaps scales the output taps that eco quality drops, interpolate
+  // smooths the modulated reads.
   inline std::tuple<float, float> process(float input, float size, float decay,
                                           float damping, float modRate,
-                                          float modDepth) {
+                                          float modDepth, float extraTaps,
+                                          bool interpolate) {
     float out_l = 0.0f;
     float out_r = 0.0f;
 
@@ -103,62 +323,82 @@ class ReverbTank {
         std::sin(2.0f * 3.141592f * modPhase_ / fs_) * 128.0f * modDepth;
     modPhase_ += 3.0f * modRate;
 
-    auto tank1 = decayDiffusion1Left_.process(
-                     input, size * Diffusion1BaseDelayLeft - 1.0f + mod) +
-                 decay * delay2Right_.read(size * delay2Right_.size() - 1.0f);
-    delay1Left_.write(tank1);
-    tank1 = delay1Left_.read(size * delay1Left_.size() - 1.0f);
+    // Lines written earlier in this step are read one frame closer, as the
+    // frame is only committed once both sides are written.
+    const auto delay1Left = size * Diffusion1BaseDelayLeft - 1.0f + mod;
+    const auto delay1Right = size * Diffusion1BaseDelayRight - 1.0f + mod;
+
+    auto tank1 = (interpolate ? decayDiffusion1Left_.processInterpolated(
+                                    input, delay1Left)
+                              : decayDiffusion1Left_.process(input, delay1Left)) +
+                 decay * delay2_.read(Right, size * delay2_.size(Right) - 1.0f);
+    delay1_.write(Left, tank1);
+    tank1 = delay1_.read(Left, size * delay1_.size(Left) - 2.0f);
     tank1 = dampingLeft_.process(tank1, 1.0f - damping, damping);
     tank1 = decayDiffusion2Left_.process(
         tank1 * decay, size * decayDiffusion2Left_.size() - 1.0f);
-    delay2Left_.write(tank1);
-
-    auto tank2 = decayDiffusion1Right_.process(
-                     input, size * Diffusion1BaseDelayRight - 1.0f + mod) +
-                 decay * delay2Left_.read(size * delay2Left_.size() - 1.0f);
-    delay1Right_.write(tank2);
-    tank2 = delay1Right_.read(size * delay1Right_.size() - 1.0f);
+    delay2_.write(Left, tank1);
+
+    auto tank2 = (interpolate ? decayDiffusion1Right_.processInterpolated(
+                                    input, delay1Right)
+                              : decayDiffusion1Right_.process(input, delay1Right)) +
+                 decay * delay2_.read(Left, size * delay2_.size(Left) - 2.0f);
+    delay1_.write(Right, tank2);
+    tank2 = delay1_.read(Right, size * delay1_.size(Right) - 2.0f);
     tank2 = dampingRight_.process(tank2, 1.0f - damping, damping);
     tank2 = decayDiffusion2Right_.process(
         tank2 * decay, size * decayDiffusion2Right_.size() - 1.0f);
-    delay2Right_.write(tank2);
+    delay2_.write(Right, tank2);
+
+    delay1_.advance();
+    delay2_.advance();
 
+    // The first four taps of each side read the opposite half of the tank
+    // and are always on; eco quality drops the other three.
     const float ratio = fs_ / 29761.0f;
-    out_l += 0.6f * delay1Right_.read(2 * size * 266.0f * ratio);
-    out_l += 0.6f * delay1Right_.read(2 * size * 2974.0f * ratio);
+    const float extra = 0.6f * extraTaps;
+    out_l += 0.6f * delay1_.read(Right, 2 * size * 266.0f * ratio);
+    out_l += 0.6f * delay1_.read(Right, 2 * size * 2974.0f * ratio);
     out_l -= 0.6f * decayDiffusion2Right_.tap(2 * size * 1913.0f * ratio);
-    out_l += 0.6f * delay2Right_.read(2 * size * 1996.0f * ratio);
-    out_l -= 0.6f * delay1Left_.read(2 * size * 1990.0f * ratio);
-    out_l -= 0.6f * decayDiffusion2Left_.tap(2 * size * 187.0f * ratio);
-    out_l -= 0.6f * delay2Left_.read(2 * size * 1066.0f * ratio);
+    out_l += 0.6f * delay2_.read(Right, 2 * size * 1996.0f * ratio);
 
-    out_r += 0.6f * delay1Left_.read(2 * size * 353.0f * ratio);
-    out_r += 0.6f * delay1Left_.read(2 * size * 3627.0f * ratio);
+    out_r += 0.6f * delay1_.read(Left, 2 * size * 353.0f * ratio);
+    out_r += 0.6f * delay1_.read(Left, 2 * size * 3627.0f * ratio);
     out_r -= 0.6f * decayDiffusion2Left_.tap(2 * size * 1228.0f * ratio);
-    out_r += 0.6f * delay2Left_.read(2 * size * 2673.0f * ratio);
-    out_r -= 0.6f * delay2Right_.read(2 * size * 2111.0f * ratio);
-    out_r -= 0.6f * decayDiffusion2Right_.tap(2 * size * 335.0f * ratio);
-    out_r -= 0.6f * delay2Right_.read(2 * size * 121.0f * ratio);
+    out_r += 0.6f * delay2_.read(Left, 2 * size * 2673.0f * ratio);
+
+    if (extraTaps > 0.0f) {
+      out_l -= extra * delay1_.read(Left, 2 * size * 1990.0f * ratio);
+      out_l -= extra * decayDiffusion2Left_.tap(2 * size * 187.0f * ratio);
+      out_l -= extra * delay2_.read(Left, 2 * size * 1066.0f * ratio);
+
+      out_r -= extra * delay2_.read(Right, 2 * size * 2111.0f * ratio);
+      out_r -= extra * decayDiffusion2Right_.tap(2 * size * 335.0f * ratio);
+      out_r -= extra * delay2_.read(Right, 2 * size * 121.0f * ratio);
+    }
 
     return {out_l, out_r};
   }
 
  private:
+  static constexpr std::size_t Left = 0;
+  static constexpr std::size_t Right = 1;
+
   // left side of tank
   const std::uint32_t Diffusion1BaseDelayLeft = 2 * 995;
   Allpass decayDiffusion1Left_{Diffusion1BaseDelayLeft + 128, 0.7, -0.7};
   Allpass decayDiffusion2Left_{2 * 2667, -0.5, 0.5};
-  Delay delay1Left_{2 * 6598};
   LPFilter dampingLeft_{};
-  Delay delay2Left_{2 * 5512};
 
   // right side of tank
   const std::uint32_t Diffusion1BaseDelayRight = 2 * 1345;
   Allpass decayDiffusion1Right_{Diffusion1BaseDelayRight + 128, 0.7f, -0.7f};
   Allpass decayDiffusion2Right_{2 * 3935, -0.5f, 0.5f};
-  Delay delay1Right_{2 * 6248};
   LPFilter dampingRight_{};
-  Delay delay2Right_{2 * 4687};
+
+  // delay lines of both sides, as left/right frames
+  FrameDelay<2> delay1_{{2 * 6598, 2 * 6248}};
+  FrameDelay<2> delay2_{{2 * 5512, 2 * 4687}};
 
   float fs_;
   float modPhase_{};
@@ -166,8 +406,8 @@ class ReverbTank {
 
 class ReverbParam : public AudioProcessorParameter {
  public:
-  ReverbParam(const String& name, float defaultValue)
-      : name_(name), defaultValue_(defaultValue) {
+  ReverbParam(const String& name, float defaultValue, int numSteps = 0)
+      : name_(name), defaultValue_(defaultValue), numSteps_(numSteps) {
     value_.store(defaultValue);
   }
 
@@ -175,7 +415,7 @@ class ReverbParam : public AudioProcessorParameter {
 
   void setValue(float v) override { value_.store(v); }
 
-  float getDefaultValue() const override { return 0.5f; }
+  float getDefaultValue() const override { return defaultValue_; }
 
   String getName(int maximumStringLength) const override { return name_; }
 
@@ -183,8 +423,18 @@ class ReverbParam : public AudioProcessorParameter {
 
   float getValueForText(const String& text) const override { return 0.0f; }
 
+  int getNumSteps() const override {
+    return numSteps_ > 0 ? numSteps_
+                         : AudioProcessor::getDefaultNumParameterSteps();
+  }
+
+  bool isDiscrete() const override { return numSteps_ > 0; }
+
+  bool isBoolean() const override { return numSteps_ == 2; }
+
   String name_;
   float defaultValue_;
+  int numSteps_;
   std::atomic<float> value_;
 };
 
@@ -202,6 +452,15 @@ class Reverb2AudioProcessor : public juce::AudioProcessor {
   bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
 
   void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+  void processBlockBypassed(juce::AudioBuffer<float>&,
+                            juce::MidiBuffer&) override;
+
+  // processBlock() on plain stereo channel pointers. in and out may be the
+  // same buffers.
+  void process(const float* inL, const float* inR, float* outL, float* outR,
+               int numSamples);
+
+  AudioProcessorParameter* getBypassParameter() const override;
 
   //==============================================================================
   juce::AudioProcessorEditor* createEditor() override;
@@ -228,16 +487,122 @@ class Reverb2AudioProcessor : public juce::AudioProcessor {
 
   std::vector<AudioProcessorParameter*> getParameters();
 
+  // Name of the DSP kernel variant this instance runs, for logging
+  const char* getKernelVariant() const { return kernels_.name; }
+
  private:
+  static constexpr char StateTag[5] = "RVB2";
+  static constexpr std::uint32_t MaxPreDelay = 20000;
+  // Input diffusers eco quality runs
+  static constexpr std::size_t EcoDiffusers = 2;
+  // Time to fade detail in or out when the quality tier changes
+  static constexpr double DetailFadeSeconds = 0.05;
+
+  struct TankSettings {
+    float mix;
+    float size;
+    float decay;
+    float damping;
+    float speed;
+    float depth;
+    float early;
+    bool interpolate;
+  };
+
+  // Front stage work handed to the pipeline worker, in ring positions
+  struct FrontJob {
+    int start;
+    int numSamples;
+    std::uint32_t predelay;
+    float size;
+    float detailTarget;
+    bool hasAux;
+    bool hasEarly;
+  };
+
+  // An aux input bus, with its own predelay line. The channel pointers are
+  // only set during processBlock() and advance with each run.
+  struct AuxInput {
+    Delay predelay{};
+    bool active{};
+    const float* left{};
+    const float* right{};
+  };
+
+  int processFrontStage(const float* left, const float* right,
+                        const float* aux, int numSamples,
+                        std::uint32_t predelay, float size, float detail,
+                        bool early);
+  const float* sumAuxInputs(int numSamples);
+  void processTank(const float* diffused, const float* detail,
+                   const float* earlyL, const float* earlyR,
+                   const float* left, const float* right, float* outL,
+                   float* outR, int numSamples, const TankSettings& settings);
+  void stepDetail(int numSamples, float target);
+  void processWithBypass(const float* inL, const float* inR, float* outL,
+                         float* outR, int numSamples, bool bypass);
+  void processActive(const float* inL, const float* inR, float* outL,
+                     float* outR, int numSamples);
+  void readDry(const float* inL, const float* inR, float* outL, float* outR,
+               int numSamples);
+  void clearMemory();
+  template <typename Fn>
+  void processMainBus(juce::AudioBuffer<float>& buffer, Fn&& fn);
+  void processPipelined(const float* inL, const float* inR, const float* aux,
+                        float* outL, float* outR, int numSamples,
+                        const FrontJob& job, const TankSettings& settings);
+  void runPipelineFrontStage();
+
   std::vector<AudioProcessorParameter*> parameters_{};
+  const DspKernels& kernels_{getDspKernels()};
   float sizeCurrent_{};
-  Delay predelay_{20001};
+  Delay predelay_{};
+  // The predelayed main and aux inputs, as the tank takes them, for the
+  // early reflections to tap
+  Delay earlyInput_{};
   LPFilter predelayFilter_{};
-  std::vector<Allpass> inputDiffusionAps_{{2 * 210, -0.75, 0.75},
-                                          {2 * 148, -0.75, 0.75},
-                                          {2 * 561, -0.625, 0.625},
-                                          {2 * 410, -0.625, 0.625}};
+  std::array<Allpass, 4> inputDiffusionAps_{{{2 * 210, -0.75, 0.75},
+                                             {2 * 148, -0.75, 0.75},
+                                             {2 * 561, -0.625, 0.625},
+                                             {2 * 410, -0.625, 0.625}}};
+  // Front stage scratch: two diffuser buffers, the eco diffusion and the
+  // early reflections
+  enum Scratch { ScratchA, ScratchB, ScratchEco, EarlyLeft, EarlyRight };
+  std::array<std::vector<float>, 5> scratch_{};
+  EarlyReflections early_{};
   ReverbTank reverbTank_{};
+  QualityGovernor governor_{};
+  // Crossfade between eco (0) and full (1) diffusion and tank taps
+  float detail_{1.0f};
+  float detailStep_{};
+  BypassFade bypass_{};
+  // Shared tank mode: the aux inputs, and their predelayed sum at the send
+  // gains for the current run
+  std::array<AuxInput, MaxAuxInputs> auxInputs_{};
+  std::vector<float> auxSum_{};
+  std::vector<float> auxMono_{};
+  // Right side of a mono main bus, which has no channel for it
+  std::vector<float> monoRight_{};
+  // Prepared block size; longer host blocks are split into runs of this
+  int maxBlockSize_{1};
+
+  // Pipelined mode runs the front stage one block ahead on worker_. Its
+  // input and output live in rings of two blocks: the front stage fills one
+  // block while the tank drains the block before it.
+  bool pipelined_{};
+  std::unique_ptr<StageWorker> worker_{};
+  FrontJob frontJob_{};
+  int pipelinePos_{};
+  enum PipelineRing {
+    DryLeft,
+    DryRight,
+    AuxSum,
+    Diffused,
+    DiffusedDetail,
+    EarlyLeftRing,
+    EarlyRightRing
+  };
+  std::array<std::vector<float>, 7> pipelineRings_{};
 
   //==============================================================================
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Reverb2AudioProcessor)
@@ -0,0 +1,7 @@
+#include "delay_processor.h"
+#include "stress.h"
+
+StressTarget createDelayTarget() {
+  return {"delay", std::make_unique<DelayAudioProcessor>(),
+          DelayParameters::Time, DelayParameters::LongDelay};
+}
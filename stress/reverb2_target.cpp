@@ -0,0 +1,7 @@
+#include "reverb2_processor.h"
+#include "stress.h"
+
+StressTarget createReverb2Target() {
+  return {"reverb2", std::make_unique<Reverb2AudioProcessor>(),
+          ReverbParameters::Size, ReverbParameters::Pipeline};
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+using namespace juce;
+
+// A processor for the stress run, with the parameters it treats specially
+struct StressTarget {
+  String name;
+  std::unique_ptr<AudioProcessor> processor;
+  // Swept over its whole range, a step every block
+  int sweepParameter;
+  // Only read in prepareToPlay, so it only changes between runs
+  int latchedParameter;
+};
+
+StressTarget createReverb2Target();
+StressTarget createDelayTarget();
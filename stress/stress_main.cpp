@@ -0,0 +1,270 @@
+#include <algorithm>
+#include <iostream>
+
+#include "stress.h"
+
+// Drives the processors the way a bad night on stage would: random block
+// sizes, a parameter changing every block, input decaying into the denormal
+// range and sample rate changes through prepareToPlay. Every block is timed
+// against its deadline, the time the block lasts at the sample rate, and the
+// report shows the tail of that distribution, where the dropouts are.
+//
+// Usage: stress [--seconds S] [--max-block N] [--seed N] [--max-load L]
+//
+// S seconds of audio are processed per sample rate and processor. With
+// --max-load, exits with 1 if any block took more than L of its deadline.
+
+namespace {
+
+constexpr double SampleRates[] = {44100.0, 48000.0, 88200.0, 96000.0,
+                                  192000.0};
+
+// Time for the swept parameter to cross its range
+constexpr double SweepSeconds = 0.25;
+
+// Upper bucket edges, as fractions of the deadline
+constexpr double BucketEdges[] = {0.001, 0.002, 0.005, 0.01, 0.02, 0.05,
+                                  0.1,   0.2,   0.5,   1.0,  2.0};
+constexpr int NumBuckets = numElementsInArray(BucketEdges) + 1;
+
+struct Options {
+  double seconds = 10.0;
+  int maxBlock = 2048;
+  int64 seed = 1;
+  double maxLoad = 0.0;
+};
+
+struct BlockTime {
+  double load;  // Fraction of the deadline
+  double seconds;
+  double sampleRate;
+  int numSamples;
+};
+
+// Bursts of noise under an exponential decay, each followed by silence long
+// enough for the processors' tails to fall into the denormal range. The
+// silence is sometimes not quite silent, but denormal itself.
+class DecayingInput {
+ public:
+  explicit DecayingInput(Random& random) : random_(random) {}
+
+  void prepare(double sampleRate) {
+    sampleRate_ = sampleRate;
+    remaining_ = 0;
+    silent_ = true;
+  }
+
+  void fill(float* left, float* right, int numSamples) {
+    for (auto i = 0; i < numSamples; ++i) {
+      if (--remaining_ <= 0) startSection();
+
+      if (silent_) {
+        left[i] = right[i] = tiny_;
+      } else {
+        left[i] = level_ * (2.0f * random_.nextFloat() - 1.0f);
+        right[i] = level_ * (2.0f * random_.nextFloat() - 1.0f);
+        level_ *= decay_;
+      }
+    }
+  }
+
+ private:
+  void startSection() {
+    silent_ = !silent_;
+    if (silent_) {
+      remaining_ = static_cast<int>(sampleRate_ * (1.0 + random_.nextDouble()));
+      tiny_ = random_.nextBool() ? std::numeric_limits<float>::denorm_min() *
+                                       static_cast<float>(random_.nextInt(64))
+                                 : 0.0f;
+    } else {
+      // Down to about 1e-30 by the end of the burst
+      const auto seconds = 0.05 + random_.nextDouble();
+      remaining_ = static_cast<int>(sampleRate_ * seconds);
+      level_ = random_.nextFloat();
+      decay_ = static_cast<float>(std::pow(1e-30, 1.0 / remaining_));
+    }
+  }
+
+  Random& random_;
+  double sampleRate_{};
+  int remaining_{};
+  bool silent_{};
+  float level_{};
+  float decay_{};
+  float tiny_{};
+};
+
+int randomBlockSize(Random& random, int maxBlock) {
+  switch (random.nextInt(4)) {
+    case 0:  // Power of two, as most hosts use
+      return jmin(maxBlock, 1 << random.nextInt(12));
+    case 1:  // A few samples, as around loop points and automation splits
+      return 1 + random.nextInt(jmin(maxBlock, 32));
+    default:
+      return 1 + random.nextInt(maxBlock);
+  }
+}
+
+// Runs the target over every sample rate, timing each block
+std::vector<BlockTime> runTarget(StressTarget& target, const Options& options,
+                                 Random& random) {
+  auto& processor = *target.processor;
+  const auto& parameters = processor.getParameters();
+
+  AudioBuffer<float> buffer(2, options.maxBlock);
+  MidiBuffer midi;
+  DecayingInput input(random);
+
+  std::vector<BlockTime> times;
+  times.reserve(static_cast<size_t>(
+      options.seconds * numElementsInArray(SampleRates) * SampleRates[0] /
+      (options.maxBlock / 4)));
+
+  // Visit the rates in a random order, so each change is a different jump
+  auto rates = std::vector<double>(std::begin(SampleRates),
+                                   std::end(SampleRates));
+  for (auto i = static_cast<int>(rates.size()) - 1; i > 0; --i) {
+    std::swap(rates[static_cast<size_t>(i)],
+              rates[static_cast<size_t>(random.nextInt(i + 1))]);
+  }
+
+  auto prepared = false;
+  for (const auto rate : rates) {
+    // Flip the latched mode on a coin toss and switch rates like a host
+    parameters[target.latchedParameter]->setValue(random.nextBool() ? 1.0f
+                                                                    : 0.0f);
+    if (prepared) processor.releaseResources();
+    processor.setRateAndBufferSizeDetails(rate, options.maxBlock);
+    processor.prepareToPlay(rate, options.maxBlock);
+    prepared = true;
+    input.prepare(rate);
+
+    auto sweep = 0.0;
+    auto sweepDirection = 1.0;
+    const auto totalSamples = static_cast<int64>(options.seconds * rate);
+
+    for (int64 done = 0; done < totalSamples;) {
+      const auto n = static_cast<int>(jmin<int64>(
+          randomBlockSize(random, options.maxBlock), totalSamples - done));
+
+      // Automation storm: the swept parameter moves every block, and most
+      // blocks another parameter jumps somewhere at random
+      sweep += sweepDirection * n / (SweepSeconds * rate);
+      if (sweep > 1.0 || sweep < 0.0) {
+        sweepDirection = -sweepDirection;
+        sweep = jlimit(0.0, 1.0, sweep);
+      }
+      parameters[target.sweepParameter]->setValue(static_cast<float>(sweep));
+
+      if (random.nextInt(4) != 0) {
+        const auto index = random.nextInt(parameters.size());
+        if (index != target.latchedParameter &&
+            index != target.sweepParameter) {
+          parameters[index]->setValue(random.nextFloat());
+        }
+      }
+
+      input.fill(buffer.getWritePointer(0), buffer.getWritePointer(1), n);
+      AudioBuffer<float> block(buffer.getArrayOfWritePointers(), 2, n);
+
+      const auto startTicks = Time::getHighResolutionTicks();
+      processor.processBlock(block, midi);
+      const auto elapsed = Time::highResolutionTicksToSeconds(
+          Time::getHighResolutionTicks() - startTicks);
+
+      times.push_back({elapsed * rate / n, elapsed, rate, n});
+      done += n;
+    }
+  }
+
+  processor.releaseResources();
+  return times;
+}
+
+// Prints the histogram and tail of the block loads, and returns the worst
+double report(const String& name, std::vector<BlockTime> times) {
+  std::sort(times.begin(), times.end(),
+            [](const auto& a, const auto& b) { return a.load < b.load; });
+
+  std::array<int64, NumBuckets> counts{};
+  for (const auto& time : times) {
+    const auto bucket =
+        std::upper_bound(std::begin(BucketEdges), std::end(BucketEdges),
+                         time.load) -
+        std::begin(BucketEdges);
+    ++counts[static_cast<size_t>(bucket)];
+  }
+
+  const auto percentile = [&](double p) {
+    const auto index = static_cast<size_t>(
+        std::ceil(p / 100.0 * static_cast<double>(times.size())));
+    return times[jlimit<size_t>(0, times.size() - 1, index - 1)].load;
+  };
+  const auto& worst = times.back();
+  const auto overruns = std::count_if(
+      times.begin(), times.end(), [](const auto& t) { return t.load > 1.0; });
+
+  std::cout << "\n" << name << ": " << times.size() << " blocks\n";
+  std::cout << "  load (fraction of the block deadline)\n";
+
+  const auto maxCount = *std::max_element(counts.begin(), counts.end());
+  for (auto i = 0; i < NumBuckets; ++i) {
+    const auto label =
+        i < NumBuckets - 1
+            ? "< " + String(BucketEdges[i] * 100.0, 1) + "%"
+            : ">= " + String(BucketEdges[NumBuckets - 2] * 100.0, 1) + "%";
+    const auto bar = maxCount > 0 ? static_cast<int>(40 * counts[i] /
+                                                     maxCount)
+                                  : 0;
+    std::cout << "  " << label.paddedLeft(' ', 9) << " "
+              << String(counts[i]).paddedLeft(' ', 10) << " "
+              << String::repeatedString("#", bar) << "\n";
+  }
+
+  std::cout << "  p50   " << percentile(50.0) * 100.0 << "%\n"
+            << "  p99   " << percentile(99.0) * 100.0 << "%\n"
+            << "  p99.9 " << percentile(99.9) * 100.0 << "%\n"
+            << "  max   " << worst.load * 100.0 << "% ("
+            << worst.seconds * 1e6 << " us for " << worst.numSamples
+            << " samples at " << worst.sampleRate << " Hz)\n"
+            << "  overruns " << overruns << "\n";
+
+  return worst.load;
+}
+
+Options parseOptions(const StringArray& args) {
+  Options options;
+  for (auto i = 0; i + 1 < args.size(); i += 2) {
+    const auto& value = args[i + 1];
+    if (args[i] == "--seconds") {
+      options.seconds = jmax(0.1, value.getDoubleValue());
+    } else if (args[i] == "--max-block") {
+      options.maxBlock = jlimit(1, 1 << 16, value.getIntValue());
+    } else if (args[i] == "--seed") {
+      options.seed = value.getLargeIntValue();
+    } else if (args[i] == "--max-load") {
+      options.maxLoad = value.getDoubleValue();
+    }
+  }
+  return options;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  StringArray args;
+  for (auto i = 1; i < argc; ++i) args.add(argv[i]);
+  const auto options = parseOptions(args);
+
+  StressTarget targets[] = {createReverb2Target(), createDelayTarget()};
+
+  auto failed = false;
+  for (auto& target : targets) {
+    Random random(options.seed);
+    const auto worst =
+        report(target.name, runTarget(target, options, random));
+    failed |= options.maxLoad > 0.0 && worst > options.maxLoad;
+  }
+
+  return failed ? 1 : 0;
+}
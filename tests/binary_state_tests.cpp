@@ -0,0 +1,201 @@
+#include "delay_processor.h"
+#include "reverb2_processor.h"
+
+// The binary state format: its byte layout, round trips and states written
+// by other versions, mostly through the delay.
+class BinaryStateTests : public UnitTest {
+ public:
+  BinaryStateTests() : UnitTest("Binary state", "state") {}
+
+  void runTest() override {
+    beginTest("Layout");
+    {
+      DelayAudioProcessor processor;
+      auto params = processor.getParameters();
+      params[DelayParameters::Mix]->setValue(0.75f);
+
+      MemoryBlock state;
+      processor.getStateInformation(state);
+      const auto* bytes = static_cast<const std::uint8_t*>(state.getData());
+      expectEquals(static_cast<int>(state.getSize()),
+                   8 + 4 * static_cast<int>(DelayParameters::End));
+      expect(std::memcmp(bytes, "DLAY", 4) == 0);
+      expectEquals(bytes[4] | bytes[5] << 8, 1);
+      expectEquals(bytes[6] | bytes[7] << 8,
+                   static_cast<int>(DelayParameters::End));
+
+      // 0.75f is 0x3f400000, little-endian
+      const std::uint8_t mix[] = {0x00, 0x00, 0x40, 0x3f};
+      expect(std::memcmp(bytes + 8 + 4 * DelayParameters::Mix, mix, 4) == 0);
+    }
+
+    beginTest("Round trip");
+    {
+      DelayAudioProcessor source;
+      Random random(1);
+      for (auto* param : source.getParameters()) {
+        param->setValue(random.nextFloat());
+      }
+
+      MemoryBlock state;
+      source.getStateInformation(state);
+      DelayAudioProcessor restored;
+      restored.setStateInformation(state.getData(),
+                                   static_cast<int>(state.getSize()));
+      expect(sameValues(source.getParameters(), restored.getParameters()));
+    }
+
+    beginTest("Reverb2 round trip");
+    {
+      Reverb2AudioProcessor source;
+      Random random(2);
+      for (auto* param : source.getParameters()) {
+        param->setValue(random.nextFloat());
+      }
+
+      MemoryBlock state;
+      source.getStateInformation(state);
+      Reverb2AudioProcessor restored;
+      restored.setStateInformation(state.getData(),
+                                   static_cast<int>(state.getSize()));
+      expect(sameValues(source.getParameters(), restored.getParameters()));
+    }
+
+    beginTest("Older state resets missing parameters");
+    {
+      // A state from before LongTime existed, loaded over a changed value
+      DelayAudioProcessor processor;
+      auto params = processor.getParameters();
+      params[DelayParameters::LongTime]->setValue(0.9f);
+      const auto state = makeState("DLAY", 1, {0.2f, 0.4f, 0.6f}, 3);
+      processor.setStateInformation(state.getData(),
+                                    static_cast<int>(state.getSize()));
+
+      expectEquals(params[DelayParameters::Mix]->getValue(), 0.2f);
+      expectEquals(params[DelayParameters::Time]->getValue(), 0.4f);
+      expectEquals(params[DelayParameters::Feedback]->getValue(), 0.6f);
+      for (auto i = 3; i < DelayParameters::End; ++i) {
+        expectEquals(params[static_cast<size_t>(i)]->getValue(),
+                     DelayParameterSpecs[i].defaultValue);
+      }
+    }
+
+    beginTest("Legacy XML state resets parameters it has no key for");
+    {
+      Reverb2AudioProcessor processor;
+      auto params = processor.getParameters();
+      params[EarlyLevel]->setValue(0.8f);
+      params[auxParameterIndex(0, AuxSend)]->setValue(0.2f);
+
+      XmlElement xml("Reverb2");
+      xml.setAttribute("Mix", 0.5);
+      MemoryBlock state;
+      AudioProcessor::copyXmlToBinary(xml, state);
+      processor.setStateInformation(state.getData(),
+                                    static_cast<int>(state.getSize()));
+
+      expectEquals(params[ReverbParameters::Mix]->getValue(), 0.5f);
+      expectEquals(params[ReverbParameters::Size]->getValue(),
+                   ReverbParameterSpecs[ReverbParameters::Size].defaultValue);
+      for (auto* param : params) {
+        if (param != params[ReverbParameters::Mix]) {
+          expectEquals(param->getValue(), param->getDefaultValue());
+        }
+      }
+    }
+
+    beginTest("Newer parameters are skipped");
+    {
+      DelayAudioProcessor processor;
+      auto params = processor.getParameters();
+      std::vector<float> values(params.size() + 3, 0.125f);
+      const auto state = makeState("DLAY", 1, values, values.size());
+      processor.setStateInformation(state.getData(),
+                                    static_cast<int>(state.getSize()));
+      for (auto* param : params) expectEquals(param->getValue(), 0.125f);
+    }
+
+    beginTest("Truncated state loads what is there");
+    {
+      DelayAudioProcessor processor;
+      auto params = processor.getParameters();
+      // Cut off halfway through the third value
+      const auto state = makeState("DLAY", 1, {0.2f, 0.4f, 0.6f},
+                                   DelayParameters::End);
+      processor.setStateInformation(
+          state.getData(), static_cast<int>(BinaryState::HeaderSize) + 10);
+      expectEquals(params[DelayParameters::Mix]->getValue(), 0.2f);
+      expectEquals(params[DelayParameters::Time]->getValue(), 0.4f);
+      expectEquals(params[DelayParameters::Feedback]->getValue(),
+                   DelayParameterSpecs[DelayParameters::Feedback]
+                       .defaultValue);
+    }
+
+    beginTest("Newer format version is rejected");
+    {
+      DelayAudioProcessor processor;
+      auto params = processor.getParameters();
+      params[DelayParameters::Mix]->setValue(0.9f);
+      const auto state = makeState("DLAY", BinaryState::Version + 1,
+                                   {0.2f, 0.4f, 0.6f}, 3);
+      processor.setStateInformation(state.getData(),
+                                    static_cast<int>(state.getSize()));
+      expectEquals(params[DelayParameters::Mix]->getValue(), 0.9f);
+      expectEquals(params[DelayParameters::Time]->getValue(),
+                   DelayParameterSpecs[DelayParameters::Time].defaultValue);
+    }
+
+    beginTest("Other tags are not read as binary states");
+    {
+      Reverb2AudioProcessor reverb;
+      reverb.getParameters()[ReverbParameters::Mix]->setValue(0.2f);
+      MemoryBlock state;
+      reverb.getStateInformation(state);
+
+      DelayAudioProcessor processor;
+      expect(BinaryState::read(state.getData(),
+                               static_cast<int>(state.getSize()), "DLAY",
+                               processor.getParameters()) ==
+             BinaryState::ReadResult::NotBinary);
+      expectEquals(processor.getParameters()[DelayParameters::Mix]->getValue(),
+                   DelayParameterSpecs[DelayParameters::Mix].defaultValue);
+    }
+  }
+
+ private:
+  // A state as BinaryState::write() lays it out, with a chosen version and
+  // parameter count
+  static MemoryBlock makeState(const char (&tag)[5], int version,
+                               const std::vector<float>& values,
+                               size_t count) {
+    MemoryBlock state;
+    state.setSize(BinaryState::HeaderSize + 4 * jmax(count, values.size()),
+                  true);
+    auto* bytes = static_cast<std::uint8_t*>(state.getData());
+    std::memcpy(bytes, tag, 4);
+    bytes[4] = static_cast<std::uint8_t>(version);
+    bytes[5] = static_cast<std::uint8_t>(version >> 8);
+    bytes[6] = static_cast<std::uint8_t>(count);
+    bytes[7] = static_cast<std::uint8_t>(count >> 8);
+    for (size_t i = 0; i < values.size(); ++i) {
+      std::uint32_t bits;
+      std::memcpy(&bits, &values[i], sizeof(bits));
+      for (auto b = 0; b < 4; ++b) {
+        bytes[BinaryState::HeaderSize + 4 * i + static_cast<size_t>(b)] =
+            static_cast<std::uint8_t>(bits >> (8 * b));
+      }
+    }
+    return state;
+  }
+
+  static bool sameValues(const std::vector<AudioProcessorParameter*>& a,
+                         const std::vector<AudioProcessorParameter*>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+      if (a[i]->getValue() != b[i]->getValue()) return false;
+    }
+    return true;
+  }
+};
+
+static BinaryStateTests binaryStateTests;
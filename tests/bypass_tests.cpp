@@ -0,0 +1,109 @@
+#include "delay_processor.h"
+#include "reverb2_processor.h"
+
+// Host bypass switched on and off mid-stream. Once the fade is done the
+// output is the input, late by the processor's latency, and the processor
+// comes back from silence: nothing it held before the bypass is heard again.
+class BypassTests : public UnitTest {
+ public:
+  BypassTests() : UnitTest("Bypass", "bypass") {}
+
+  void runTest() override {
+    beginTest("Delay");
+    {
+      // The echoes due while bypassed, and a whole line after it, would
+      // still come out had the line not been emptied
+      DelayAudioProcessor processor;
+      processor.prepareToPlay(SampleRate, BlockSize);
+      toggleBypass(processor, DelayParameters::Bypass);
+    }
+
+    for (auto pipelined : {false, true}) {
+      beginTest(pipelined ? "Reverb2, pipelined" : "Reverb2");
+      Reverb2AudioProcessor processor;
+      processor.getParameters()[ReverbParameters::Pipeline]->setValue(
+          pipelined ? 1.0f : 0.0f);
+      processor.prepareToPlay(SampleRate, BlockSize);
+      toggleBypass(processor, ReverbParameters::Bypass);
+    }
+  }
+
+ private:
+  static constexpr double SampleRate = 48000.0;
+  static constexpr int BlockSize = 256;
+  // Blocks of noise before the bypass, of noise and then silence while
+  // bypassed, and of silence after it
+  static constexpr int ActiveBlocks = 40;
+  static constexpr int BypassedBlocks = 24;
+  static constexpr int SilentBlocks = 4;
+  static constexpr int ReturnBlocks = 260;
+  // Longer than any bypass fade
+  static constexpr int FadeSamples = 2048;
+
+  void toggleBypass(AudioProcessor& processor, int bypassIndex) {
+    auto* bypass = processor.getParameters()[bypassIndex];
+    const auto latency = processor.getLatencySamples();
+    Random random(3);
+    std::array<std::vector<float>, 2> inputs;
+    std::array<std::vector<float>, 2> outputs;
+    AudioBuffer<float> buffer(2, BlockSize);
+    MidiBuffer midi;
+
+    const auto totalBlocks = ActiveBlocks + BypassedBlocks + ReturnBlocks;
+    for (auto block = 0; block < totalBlocks; ++block) {
+      bypass->setValue(block >= ActiveBlocks &&
+                               block < ActiveBlocks + BypassedBlocks
+                           ? 1.0f
+                           : 0.0f);
+      const auto silent =
+          block >= ActiveBlocks + BypassedBlocks - SilentBlocks;
+      for (auto channel = 0; channel < 2; ++channel) {
+        for (auto i = 0; i < BlockSize; ++i) {
+          const auto sample =
+              silent ? 0.0f : 0.5f * (2.0f * random.nextFloat() - 1.0f);
+          buffer.setSample(channel, i, sample);
+          inputs[static_cast<size_t>(channel)].push_back(sample);
+        }
+      }
+
+      processor.processBlock(buffer, midi);
+      for (auto channel = 0; channel < 2; ++channel) {
+        for (auto i = 0; i < BlockSize; ++i) {
+          outputs[static_cast<size_t>(channel)].push_back(
+              buffer.getSample(channel, i));
+        }
+      }
+    }
+
+    const auto bypassStart = ActiveBlocks * BlockSize;
+    const auto bypassEnd = (ActiveBlocks + BypassedBlocks) * BlockSize;
+    const auto total = totalBlocks * BlockSize;
+    auto fading = 0;
+    auto notDry = 0;
+    auto tail = 0;
+    for (size_t channel = 0; channel < 2; ++channel) {
+      const auto& in = inputs[channel];
+      const auto& out = outputs[channel];
+
+      // The processed signal fades out rather than stopping at once
+      for (auto i = bypassStart; i < bypassStart + BlockSize; ++i) {
+        if (out[static_cast<size_t>(i)] !=
+            in[static_cast<size_t>(i - latency)])
+          ++fading;
+      }
+      for (auto i = bypassStart + FadeSamples + latency; i < bypassEnd; ++i) {
+        if (out[static_cast<size_t>(i)] !=
+            in[static_cast<size_t>(i - latency)])
+          ++notDry;
+      }
+      for (auto i = bypassEnd; i < total; ++i) {
+        if (out[static_cast<size_t>(i)] != 0.0f) ++tail;
+      }
+    }
+    expect(fading > 0, "no fade into bypass");
+    expectEquals(notDry, 0);
+    expectEquals(tail, 0);
+  }
+};
+
+static BypassTests bypassTests;
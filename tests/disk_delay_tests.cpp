@@ -0,0 +1,121 @@
+#include "disk_delay.h"
+#include "frame_delay.h"
+
+// DiskFrameDelay against FrameDelay, the same line in memory. The line is
+// many times the pager's window, so most of what is read back has been
+// written back to the file and dropped from memory in between.
+class DiskDelayTests : public UnitTest {
+ public:
+  DiskDelayTests() : UnitTest("Disk delay", "disk_delay") {}
+
+  void runTest() override {
+    constexpr std::uint32_t Size = 3 * 48000;
+    constexpr std::uint32_t Window = 2048;
+    constexpr int BlockSize = 256;
+
+    beginTest("Matches the in-memory line through the pager");
+    DiskFrameDelay<2> disk;
+    expect(disk.allocate(Size, Window), "allocate() failed");
+    if (disk.capacity() == 0) return;
+    expectEquals(disk.size(), Size);
+
+    FrameDelay<2> memory(Size);
+    memory.allocate();
+
+    Random random(1);
+    std::vector<float> in(2 * BlockSize);
+    std::vector<float> fromDisk(2 * BlockSize);
+    std::vector<float> fromMemory(2 * BlockSize);
+    auto mismatches = 0;
+
+    for (auto block = 0; block < 4 * static_cast<int>(Size) / BlockSize;
+         ++block) {
+      for (auto& sample : in) sample = 2.0f * random.nextFloat() - 1.0f;
+
+      if (block % 8 == 7) {
+        // Sample by sample, as the delay does while its time glides
+        for (auto i = 0; i < BlockSize; ++i) {
+          const auto delay = 1.0f + random.nextFloat() * (Size - 2);
+          const auto a = disk.readFrameInterpolated(delay);
+          const auto b = memory.readFrameInterpolated(delay);
+          if (a != b) ++mismatches;
+          disk.writeFrame({in[2 * i], in[2 * i + 1]});
+          memory.writeFrame({in[2 * i], in[2 * i + 1]});
+        }
+      } else {
+        const auto delay = static_cast<std::uint32_t>(
+            BlockSize + random.nextInt(static_cast<int>(Size) - BlockSize));
+        disk.readFrames(fromDisk.data(), BlockSize, delay);
+        memory.readFrames(fromMemory.data(), BlockSize, delay);
+        if (fromDisk != fromMemory) ++mismatches;
+        disk.writeFrames(in.data(), BlockSize);
+        memory.writeFrames(in.data(), BlockSize);
+      }
+
+      // Give the pager time to move its windows and evict
+      if (block % 16 == 0) Thread::sleep(1);
+
+      // Both forget everything once, halfway through
+      if (block == 2 * static_cast<int>(Size) / BlockSize) {
+        disk.clear();
+        memory.forget();
+      }
+    }
+    expectEquals(mismatches, 0);
+
+    beginTest("Release");
+    disk.release();
+    expectEquals(disk.capacity(), 0u);
+
+    beginTest("Lines past 2^24 frames");
+    testLongLine();
+  }
+
+ private:
+  // Past 2^24 frames a float delay no longer resolves single frames. Each
+  // frame holds its own number, split over the two channels so that both
+  // halves stay exact, and reads far back must find the right one.
+  void testLongLine() {
+    constexpr std::uint32_t Size = (1U << 24) + 65536;
+    constexpr int BlockSize = 4096;
+
+    DiskFrameDelay<2> disk;
+    expect(disk.allocate(Size, 2048), "allocate() failed");
+    if (disk.capacity() == 0) return;
+
+    std::vector<float> in(2 * BlockSize);
+    std::uint32_t written = 0;
+    while (written < disk.capacity() - BlockSize) {
+      for (auto i = 0; i < BlockSize; ++i) {
+        const auto frame = written + static_cast<std::uint32_t>(i);
+        in[2 * static_cast<size_t>(i)] = static_cast<float>(frame & 0xffff);
+        in[2 * static_cast<size_t>(i) + 1] = static_cast<float>(frame >> 16);
+      }
+      disk.writeFrames(in.data(), BlockSize);
+      written += BlockSize;
+    }
+
+    // The frame read back at delay d was frame number written - d
+    const auto low = [&](std::uint32_t delay) {
+      return static_cast<float>((written - delay) & 0xffff);
+    };
+    for (const auto delay : {(1U << 24) - 1, 1U << 24, (1U << 24) + 1,
+                             (1U << 24) + 3, written - 2}) {
+      const auto frame = disk.readFrame(delay);
+      expectEquals(static_cast<std::uint32_t>(frame[0]) |
+                       static_cast<std::uint32_t>(frame[1]) << 16,
+                   written - delay);
+    }
+
+    // Halfway between two frames
+    const auto delay = (1U << 24) + 5;
+    expectEquals(disk.readFrameInterpolated(delay + 0.5)[0],
+                 low(delay) + 0.5f * (low(delay + 1) - low(delay)));
+
+    std::vector<float> run(2 * BlockSize);
+    disk.readFrames(run.data(), BlockSize, delay);
+    expectEquals(run[0], low(delay));
+  }
+};
+
+static DiskDelayTests diskDelayTests;
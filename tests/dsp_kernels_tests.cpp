@@ -0,0 +1,143 @@
+#include <juce_core/juce_core.h>
+
+#include "dsp_kernels.h"
+
+using namespace juce;
+
+// Every kernel variant this CPU can run must give the same bits as the
+// baseline: they are all built without fused multiply-adds, and the
+// processors rely on switching machines not changing their output. Lengths
+// cover the vector tails and offsets cover unaligned pointers.
+class DspKernelsTests : public UnitTest {
+ public:
+  DspKernelsTests() : UnitTest("DSP kernels", "kernels") {}
+
+  void runTest() override {
+    std::vector<const DspKernels*> variants;
+#if DSP_KERNELS_X86
+    if (SystemStats::hasAVX2()) variants.push_back(&DspKernelVariants::Avx2);
+    if (SystemStats::hasAVX512F())
+      variants.push_back(&DspKernelVariants::Avx512);
+#endif
+
+    beginTest("Dispatch");
+    {
+      const auto& selected = getDspKernels();
+      auto known = &selected == &DspKernelVariants::Baseline;
+      for (const auto* variant : variants) known |= &selected == variant;
+      expect(known, "getDspKernels() returned an unknown variant");
+    }
+
+    for (const auto* variant : variants) {
+      beginTest(String("Allpass, ") + variant->name);
+      for (auto n : Lengths) {
+        for (auto offset : Offsets) {
+          expect(sameAllpass(DspKernelVariants::Baseline, *variant, n,
+                             offset),
+                 "length " + String(n) + ", offset " + String(offset));
+        }
+      }
+
+      beginTest(String("Ping pong, ") + variant->name);
+      for (auto n : Lengths) {
+        for (auto offset : Offsets) {
+          expect(samePingPong(DspKernelVariants::Baseline, *variant, n,
+                              offset),
+                 "length " + String(n) + ", offset " + String(offset));
+        }
+      }
+
+      beginTest(String("Sparse taps, ") + variant->name);
+      for (auto n : Lengths) {
+        for (auto numTaps : {1, 3, 64}) {
+          expect(sameSparseTaps(DspKernelVariants::Baseline, *variant, n,
+                                numTaps),
+                 "length " + String(n) + ", " + String(numTaps) + " taps");
+        }
+      }
+    }
+
+    if (variants.empty()) logMessage("No other variant runs on this CPU");
+  }
+
+ private:
+  static constexpr int Lengths[] = {1, 3, 7, 8, 15, 16, 17, 31, 33, 64, 100};
+  static constexpr int Offsets[] = {0, 1, 3};
+
+  // Input with the odd denormal and large value mixed in
+  std::vector<float> makeInput(int numSamples) {
+    std::vector<float> samples(static_cast<size_t>(numSamples));
+    for (auto& sample : samples) {
+      sample = 2.0f * random_.nextFloat() - 1.0f;
+      if (random_.nextInt(16) == 0) sample *= 1.0e-39f;
+      if (random_.nextInt(16) == 0) sample *= 1.0e6f;
+    }
+    return samples;
+  }
+
+  static bool sameBits(const std::vector<float>& a,
+                       const std::vector<float>& b) {
+    return a.size() == b.size() &&
+           std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+  }
+
+  bool sameAllpass(const DspKernels& reference, const DspKernels& variant,
+                   int n, int offset) {
+    const auto in = makeInput(n + offset);
+    const auto delayed = makeInput(n + offset);
+    const auto run = [&](const DspKernels& kernels) {
+      std::vector<float> out(static_cast<size_t>(n + offset));
+      std::vector<float> write(static_cast<size_t>(n + offset));
+      kernels.allpass(in.data() + offset, delayed.data() + offset,
+                      out.data() + offset, write.data() + offset, -0.625f,
+                      0.625f, n);
+      out.insert(out.end(), write.begin(), write.end());
+      return out;
+    };
+    return sameBits(run(reference), run(variant));
+  }
+
+  bool samePingPong(const DspKernels& reference, const DspKernels& variant,
+                    int n, int offset) {
+    const auto inL = makeInput(n + offset);
+    const auto inR = makeInput(n + offset);
+    const auto delayed = makeInput(2 * (n + offset));
+    const auto run = [&](const DspKernels& kernels) {
+      std::vector<float> feedback(2 * static_cast<size_t>(n + offset));
+      std::vector<float> outL(static_cast<size_t>(n + offset));
+      std::vector<float> outR(static_cast<size_t>(n + offset));
+      kernels.pingPong(inL.data() + offset, inR.data() + offset,
+                       delayed.data() + 2 * offset,
+                       feedback.data() + 2 * offset, outL.data() + offset,
+                       outR.data() + offset, 0.3f, 0.7f, n);
+      feedback.insert(feedback.end(), outL.begin(), outL.end());
+      feedback.insert(feedback.end(), outR.begin(), outR.end());
+      return feedback;
+    };
+    return sameBits(run(reference), run(variant));
+  }
+
+  bool sameSparseTaps(const DspKernels& reference, const DspKernels& variant,
+                      int n, int numTaps) {
+    // Taps read overlapping runs of one line, at odd offsets
+    const auto line = makeInput(n + 4 * numTaps);
+    const auto gainsL = makeInput(numTaps);
+    const auto gainsR = makeInput(numTaps);
+    std::vector<const float*> taps;
+    for (auto t = 0; t < numTaps; ++t) taps.push_back(line.data() + 3 * t);
+
+    const auto run = [&](const DspKernels& kernels) {
+      std::vector<float> outL(static_cast<size_t>(n));
+      std::vector<float> outR(static_cast<size_t>(n));
+      kernels.sparseTaps(taps.data(), gainsL.data(), gainsR.data(), numTaps,
+                         outL.data(), outR.data(), n);
+      outL.insert(outL.end(), outR.begin(), outR.end());
+      return outL;
+    };
+    return sameBits(run(reference), run(variant));
+  }
+
+  Random random_{1};
+};
+
+static DspKernelsTests dspKernelsTests;
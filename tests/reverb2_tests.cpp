@@ -0,0 +1,191 @@
+#include "reverb2_processor.h"
+
+// Deterministic noise in [-1, 1), independent of Random
+static float nextNoise(std::uint32_t& state) {
+  state = state * 1664525u + 1013904223u;
+  return static_cast<float>(state >> 8) / 8388608.0f - 1.0f;
+}
+
+// Runs processor over noise followed by silence in blocks of random sizes
+// up to maxBlockSize, or all of maxBlockSize with fixedBlocks, and returns
+// the main output, its channels interleaved. The noise goes into input bus
+// inputBus; a mono bus takes the left noise only.
+static std::vector<float> render(Reverb2AudioProcessor& processor,
+                                 int numSamples, int maxBlockSize,
+                                 bool fixedBlocks, int inputBus = 0) {
+  std::uint32_t noise = 1;
+  Random blockSizes(2);
+  std::vector<float> output;
+  const auto numChannels = jmax(processor.getTotalNumInputChannels(),
+                                processor.getTotalNumOutputChannels());
+  const auto* input = processor.getBus(true, inputBus);
+  const auto left = input->getChannelIndexInProcessBlockBuffer(0);
+  const auto right = left + input->getNumberOfChannels() - 1;
+  const auto numOutputs = processor.getBus(false, 0)->getNumberOfChannels();
+  AudioBuffer<float> buffer(numChannels, maxBlockSize);
+  MidiBuffer midi;
+
+  for (auto done = 0; done < numSamples;) {
+    const auto n =
+        jmin(numSamples - done,
+             fixedBlocks ? maxBlockSize : 1 + blockSizes.nextInt(maxBlockSize));
+    buffer.setSize(numChannels, n, false, false, true);
+    buffer.clear();
+    for (auto i = 0; i < n; ++i) {
+      const auto level = done + i < numSamples / 2 ? 0.5f : 0.0f;
+      buffer.setSample(left, i, level * nextNoise(noise));
+      const auto sample = level * nextNoise(noise);
+      if (right != left) buffer.setSample(right, i, sample);
+    }
+
+    processor.processBlock(buffer, midi);
+    for (auto i = 0; i < n; ++i) {
+      for (auto channel = 0; channel < numOutputs; ++channel) {
+        output.push_back(buffer.getSample(channel, i));
+      }
+    }
+    done += n;
+  }
+  return output;
+}
+
+// Sets the main buses to main and enables the first aux input as aux
+static bool enableAux(Reverb2AudioProcessor& processor,
+                      const AudioChannelSet& main,
+                      const AudioChannelSet& aux) {
+  auto layout = processor.getBusesLayout();
+  layout.inputBuses.getReference(0) = main;
+  layout.outputBuses.getReference(0) = main;
+  layout.inputBuses.getReference(1) = aux;
+  return processor.setBusesLayout(layout);
+}
+
+// FNV-1a over the bits of samples, little-endian
+static std::uint64_t hashSamples(const std::vector<float>& samples) {
+  std::uint64_t hash = 14695981039346656037ull;
+  for (auto sample : samples) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &sample, sizeof(bits));
+    for (auto byte = 0; byte < 4; ++byte) {
+      hash ^= (bits >> (8 * byte)) & 0xff;
+      hash *= 1099511628211ull;
+    }
+  }
+  return hash;
+}
+
+class Reverb2Tests : public UnitTest {
+ public:
+  Reverb2Tests() : UnitTest("Reverb2", "reverb2") {}
+
+  void runTest() override {
+    beginTest("Default output matches the original reverb");
+    {
+      // Hash of the output of the reverb as it was before any of the
+      // block processing, quality, pipelining or early reflections work,
+      // at default parameters. Taken on x86-64, where the tank does not
+      // fuse multiply-adds; other targets may round differently.
+#if DSP_KERNELS_X86
+      constexpr std::uint64_t OriginalHash = 0x031bf865512479eaull;
+
+      Reverb2AudioProcessor processor;
+      processor.prepareToPlay(48000.0, 512);
+      const auto output = render(processor, 100 * 512, 512, true);
+      expect(hashSamples(output) == OriginalHash,
+             "default output differs from the original reverb");
+#else
+      logMessage("Skipped: the reference was taken on x86-64");
+#endif
+    }
+
+    // Without modulation the pipelined mode only moves the tank a block
+    // later; every sample must come out the same, one block late.
+    for (auto fixedBlocks : {true, false}) {
+      beginTest(fixedBlocks ? "Pipelined latency, whole blocks"
+                            : "Pipelined latency, shorter blocks");
+      constexpr auto BlockSize = 256;
+      constexpr auto NumSamples = 48000;
+
+      Reverb2AudioProcessor normal;
+      Reverb2AudioProcessor pipelined;
+      pipelined.getParameters()[ReverbParameters::Pipeline]->setValue(1.0f);
+      for (auto* processor : {&normal, &pipelined}) {
+        processor->getParameters()[ReverbParameters::Depth]->setValue(0.0f);
+        processor->prepareToPlay(48000.0, BlockSize);
+      }
+      expectEquals(normal.getLatencySamples(), 0);
+      expectEquals(pipelined.getLatencySamples(), BlockSize);
+
+      const auto expected = render(normal, NumSamples, BlockSize, fixedBlocks);
+      const auto actual =
+          render(pipelined, NumSamples, BlockSize, fixedBlocks);
+
+      auto mismatches = 0;
+      for (size_t i = 0; i < actual.size(); ++i) {
+        const auto delayed = i >= 2 * BlockSize
+                                 ? expected[i - 2 * BlockSize]
+                                 : 0.0f;
+        if (std::memcmp(&actual[i], &delayed, sizeof(float)) != 0)
+          ++mismatches;
+      }
+      expectEquals(mismatches, 0);
+    }
+
+    // At a send of 1 and the same predelay an aux input feeds the tank just
+    // as the main input does, so with the dry signal mixed out either one
+    // gives the same output. A mono main bus runs as stereo and is folded
+    // back: fed through a mono aux input, it must give the stereo output
+    // folded.
+    for (auto pipelined : {false, true}) {
+      const auto makeProcessor = [&](const AudioChannelSet& main,
+                                     const AudioChannelSet& aux) {
+        auto processor = std::make_unique<Reverb2AudioProcessor>();
+        expect(enableAux(*processor, main, aux), "layout not supported");
+        auto params = processor->getParameters();
+        params[ReverbParameters::Mix]->setValue(1.0f);
+        params[ReverbParameters::Pipeline]->setValue(pipelined ? 1.0f : 0.0f);
+        processor->prepareToPlay(48000.0, 256);
+        return processor;
+      };
+      constexpr auto NumSamples = 24000;
+
+      for (auto mono : {false, true}) {
+        beginTest(String("Aux input matches the main input, ") +
+                  (mono ? "mono" : "stereo") +
+                  (pipelined ? ", pipelined" : ""));
+        const auto channels =
+            mono ? AudioChannelSet::mono() : AudioChannelSet::stereo();
+        std::array<std::vector<float>, 2> outputs;
+        for (auto bus : {0, 1}) {
+          outputs[static_cast<size_t>(bus)] =
+              render(*makeProcessor(channels, channels), NumSamples, 256,
+                     false, bus);
+        }
+
+        expectEquals(static_cast<int>(outputs[0].size()),
+                     (mono ? 1 : 2) * NumSamples);
+        expect(outputs[0] == outputs[1], "aux and main outputs differ");
+        expect(std::any_of(outputs[0].begin(), outputs[0].end(),
+                           [](float sample) { return sample != 0.0f; }),
+               "no output");
+      }
+
+      beginTest(String("Mono main bus is the stereo output folded") +
+                (pipelined ? ", pipelined" : ""));
+      const auto mono = render(
+          *makeProcessor(AudioChannelSet::mono(), AudioChannelSet::mono()),
+          NumSamples, 256, false, 1);
+      const auto stereo = render(
+          *makeProcessor(AudioChannelSet::stereo(), AudioChannelSet::mono()),
+          NumSamples, 256, false, 1);
+      auto mismatches = 0;
+      for (size_t i = 0; i < mono.size(); ++i) {
+        if (mono[i] != (stereo[2 * i] + stereo[2 * i + 1]) * 0.5f)
+          ++mismatches;
+      }
+      expectEquals(mismatches, 0);
+    }
+  }
+};
+
+static Reverb2Tests reverb2Tests;
@@ -0,0 +1,23 @@
+#include <juce_core/juce_core.h>
+
+using namespace juce;
+
+// Runs the unit tests linked into this binary: all of them, or those of the
+// category given as the only argument. Exits with 1 if any test failed.
+//
+// Usage: aap_tests [category]
+int main(int argc, char* argv[]) {
+  UnitTestRunner runner;
+  runner.setAssertOnFailure(false);
+  if (argc > 1) {
+    runner.runTestsInCategory(argv[1]);
+  } else {
+    runner.runAllTests();
+  }
+
+  auto failures = 0;
+  for (auto i = 0; i < runner.getNumResults(); ++i) {
+    failures += runner.getResult(i)->failures;
+  }
+  return failures > 0 ? 1 : 0;
+}